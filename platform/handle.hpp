@@ -11,6 +11,10 @@
 
 #include "platform.h"
 
+#if defined(PLATFORM_LINUX)
+#include <unistd.h>
+#endif
+
 #ifndef ASSERT
 #include <cassert>
 #define ASSERT(x) assert(x)
@@ -208,6 +212,28 @@ namespace KennyKerr
 
 #endif
 
+#ifdef PLATFORM_LINUX
+
+    /// \brief POSIX file descriptor traits where invalid value is -1
+    struct file_descriptor_traits
+    {
+        using pointer = int;
+
+        static auto invalid() throw() -> pointer
+        {
+            return -1;
+        }
+
+        static auto close(pointer value) throw() -> void
+        {
+            ::close(value);
+        }
+    };
+
+    using file_descriptor = unique_handle<file_descriptor_traits>;
+
+#endif
+
 }
 
 #endif
\ No newline at end of file
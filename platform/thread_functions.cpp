@@ -1,8 +1,48 @@
 #include "thread_functions.h"
 #include "platform.h"
+#include <mutex>
+#include <vector>
 
-// current_thread_id() implementation
-// ==================================
+// thread slots shared by platform implementations
+// ===============================================
+namespace platform
+{
+    namespace
+    {
+        struct thread_slots
+        {
+            std::mutex mutex;
+            std::vector<size_t> freeSlots;
+            size_t count;
+
+            thread_slots() : count(0) {}
+        };
+
+        /// Slots are never destroyed: they are released by thread exit callbacks, which may run after static destruction
+        thread_slots &get_thread_slots()
+        {
+            static thread_slots *slots = new thread_slots();
+            return *slots;
+        }
+
+        // slot + 1, 0 means slot isn't assigned yet, so constant initialization works with __declspec(thread)
+        PLATFORM_THREAD_LOCAL size_t threadSlot = 0;
+
+        void release_thread_slot(void *value)
+        {
+            if (value == nullptr)
+                return;
+            // thread may get new slot, if it's still used by destructors of other thread local data
+            threadSlot = 0;
+            thread_slots &slots = get_thread_slots();
+            std::lock_guard<std::mutex> lock(slots.mutex);
+            slots.freeSlots.push_back(reinterpret_cast<size_t>(value) - 1);
+        }
+    }
+}
+
+// current_thread_id() and thread exit callback implementation
+// ===========================================================
 #if defined(PLATFORM_WIN32)
 namespace platform
 {
@@ -10,6 +50,24 @@ namespace platform
     {
         return thread_id_t(::GetCurrentThreadId());
     }
+
+    namespace
+    {
+        DWORD slotKey = FLS_OUT_OF_INDEXES;
+
+        void WINAPI on_thread_exit(void *value)
+        {
+            release_thread_slot(value);
+        }
+
+        /// Call release_thread_slot() on exit of current thread, slots mutex should be locked
+        void register_thread_slot(size_t slot)
+        {
+            if (slotKey == FLS_OUT_OF_INDEXES)
+                slotKey = ::FlsAlloc(&on_thread_exit);
+            ::FlsSetValue(slotKey, reinterpret_cast<void *>(slot + 1));
+        }
+    }
 }
 #elif defined(PLATFORM_LINUX)
 #include <pthread.h>
@@ -19,7 +77,53 @@ namespace platform
     {
         return pthread_self();
     }
+
+    namespace
+    {
+        pthread_key_t slotKey;
+        bool slotKeyCreated = false;
+
+        void on_thread_exit(void *value)
+        {
+            release_thread_slot(value);
+        }
+
+        /// Call release_thread_slot() on exit of current thread, slots mutex should be locked
+        void register_thread_slot(size_t slot)
+        {
+            if (!slotKeyCreated)
+                slotKeyCreated = ::pthread_key_create(&slotKey, &on_thread_exit) == 0;
+            ::pthread_setspecific(slotKey, reinterpret_cast<void *>(slot + 1));
+        }
+    }
 }
 #else
 #error Platform not supported
-#endif
\ No newline at end of file
+#endif
+
+// current_thread_slot() implementation
+// ====================================
+namespace platform
+{
+    size_t current_thread_slot()
+    {
+        if (threadSlot != 0)
+            return threadSlot - 1;
+
+        thread_slots &slots = get_thread_slots();
+        std::lock_guard<std::mutex> lock(slots.mutex);
+        size_t slot;
+        if (!slots.freeSlots.empty())
+        {
+            slot = slots.freeSlots.back();
+            slots.freeSlots.pop_back();
+        }
+        else
+        {
+            slot = slots.count++;
+        }
+        register_thread_slot(slot);
+        threadSlot = slot + 1;
+        return slot;
+    }
+}
@@ -3,10 +3,27 @@
 
 #include <cstddef>
 
+/// \brief Storage class specifier for thread local variables.
+///
+/// Visual Studio 2013 doesn't support \c thread_local,
+/// its \c __declspec(thread) works only for variables with constant initialization.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#   define PLATFORM_THREAD_LOCAL __declspec(thread)
+#else
+#   define PLATFORM_THREAD_LOCAL thread_local
+#endif
+
 namespace platform
 {
     typedef size_t thread_id_t;
     thread_id_t current_thread_id();
+
+    /// \brief Dense index of current thread: 0, 1, 2... in order of first call in each thread.
+    ///
+    /// Unlike \ref current_thread_id(), it's suitable for indexing of per-thread arrays.
+    /// Index is released on thread exit and given to next new thread, so indexes
+    /// stay below count of threads running at the same time.
+    size_t current_thread_slot();
 }
 
 #endif
@@ -2,8 +2,18 @@
 #define __STRINGS_HEADER_H__
 
 #include "array_size.h"
+#include "strings/checked_format.h"
+#include "strings/deferred_format.h"
+#include "strings/escape_format.h"
+#include "strings/file_sink.h"
+#include "strings/format.h"
 #include "strings/formatter.h"
+#include "strings/hashing_sink.h"
+#include "strings/ring_sink.h"
+#include "strings/sharded_sink.h"
+#include "strings/sinks.h"
 #include "strings/string_functions.h"
 #include "strings/string_template.h"
+#include "strings/string_view.h"
 
 #endif
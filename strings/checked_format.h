@@ -0,0 +1,286 @@
+#ifndef __CHECKED_FORMAT_HEADER_H__
+#define __CHECKED_FORMAT_HEADER_H__
+
+/// \file
+///
+/// Format patterns checked at compile time.
+///
+/// STRINGS_FORMAT_TO and STRINGS_FORMAT check that pattern literal is well-formed,
+/// refers only to passed arguments and its conversion types match types of arguments
+/// (e.g. \c {:x} for integer, \c {:.3f} for floating point value). Pattern is parsed
+/// once per call site to \ref strings::compiled_pattern, so formatting doesn't parse it.
+///
+/// ~~~{.c}
+/// STRINGS_FORMAT_TO(text, "{}: {:.2f} ({:x})", name, ratio, flags);
+/// STRINGS_FORMAT_TO(text, "{}: {:x}", name, ratio);  // error: conversion doesn't match argument type
+/// ~~~
+///
+/// Compilers without constexpr (Visual Studio 2013) format pattern without checking.
+
+#include "format.h"
+#include "escape_format.h"
+#include "string_view.h"
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+#   define STRINGS_CHECKED_PATTERNS
+#endif
+
+#if defined(STRINGS_CHECKED_PATTERNS)
+
+namespace strings
+{
+    namespace detail
+    {
+        /// Conversion types allowed for argument type, nullptr if any (user types, timestamps)
+        template <class T, class Enable = void>
+        struct pattern_argument
+        {
+            static constexpr const char *conversions() { return nullptr; }
+        };
+
+        template <class T>
+        struct is_pattern_string
+        {
+            typedef typename std::remove_cv<typename std::remove_pointer<T>::type>::type pointee;
+            static const bool value = std::is_pointer<T>::value && (std::is_same<pointee, char>::value || std::is_same<pointee, wchar_t>::value);
+        };
+
+        template <class T>
+        struct pattern_argument<T, typename std::enable_if<std::is_integral<T>::value
+            && !std::is_same<T, bool>::value && !std::is_same<T, char>::value && !std::is_same<T, wchar_t>::value>::type>
+        {
+            static constexpr const char *conversions() { return "diuoxX"; }
+        };
+
+        template <> struct pattern_argument<bool> { static constexpr const char *conversions() { return "sdiuoxX"; } };
+        template <> struct pattern_argument<char> { static constexpr const char *conversions() { return "cdiuoxX"; } };
+        template <> struct pattern_argument<wchar_t> { static constexpr const char *conversions() { return "cdiuoxX"; } };
+
+        template <class T>
+        struct pattern_argument<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+        {
+            static constexpr const char *conversions() { return "fFeEgG"; }
+        };
+
+        template <class T>
+        struct pattern_argument<T, typename std::enable_if<is_pattern_string<T>::value>::type>
+        {
+            static constexpr const char *conversions() { return "s"; }
+        };
+
+        template <class T>
+        struct pattern_argument<T, typename std::enable_if<std::is_pointer<T>::value && !is_pattern_string<T>::value>::type>
+        {
+            static constexpr const char *conversions() { return "pxX"; }
+        };
+
+        template <class Char, class Traits, class Alloc>
+        struct pattern_argument<std::basic_string<Char, Traits, Alloc> > { static constexpr const char *conversions() { return "s"; } };
+        template <class Char>
+        struct pattern_argument<basic_string_view<Char> > { static constexpr const char *conversions() { return "s"; } };
+        template <>
+        struct pattern_argument<escaped_string> { static constexpr const char *conversions() { return "s"; } };
+
+        /// Types of format arguments
+        template <class... Args>
+        struct pattern_arguments
+        {
+        };
+
+        template <class... Args>
+        pattern_arguments<typename std::decay<Args>::type...> pattern_arguments_of(const Args&...);
+
+        constexpr size_t arguments_count(pattern_arguments<>) { return 0; }
+
+        template <class First, class... Rest>
+        constexpr size_t arguments_count(pattern_arguments<First, Rest...>)
+        {
+            return 1 + arguments_count(pattern_arguments<Rest...>());
+        }
+
+        constexpr const char *argument_conversions(pattern_arguments<>, size_t) { return nullptr; }
+
+        template <class First, class... Rest>
+        constexpr const char *argument_conversions(pattern_arguments<First, Rest...>, size_t index)
+        {
+            return index == 0 ? pattern_argument<First>::conversions() : argument_conversions(pattern_arguments<Rest...>(), index - 1);
+        }
+
+        /// Result of pattern checking
+        enum pattern_check
+        {
+            pattern_valid,
+            pattern_malformed,
+            pattern_missing_argument,
+            pattern_type_mismatch
+        };
+
+        // C++11 constexpr functions consist of single return statement,
+        // so parser is written with recursion, literal text is scanned with bisection
+        // to keep recursion depth small for long patterns.
+
+        constexpr bool contains(const char *set, char c)
+        {
+            return *set != '\0' && (*set == c || contains(set + 1, c));
+        }
+
+        constexpr bool is_pattern_digit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        constexpr const char *skip_digits(const char *p)
+        {
+            return is_pattern_digit(*p) ? skip_digits(p + 1) : p;
+        }
+
+        constexpr size_t parse_pattern_index(const char *p, size_t value)
+        {
+            return is_pattern_digit(*p) ? parse_pattern_index(p + 1, value * 10 + size_t(*p - '0')) : value;
+        }
+
+        constexpr size_t find_brace(const char *pattern, size_t begin, size_t end);
+
+        constexpr size_t find_brace_after(const char *pattern, size_t found, size_t middle, size_t end)
+        {
+            return found != middle ? found : find_brace(pattern, middle, end);
+        }
+
+        /// First '{' or '}' in [begin, end) or end
+        constexpr size_t find_brace(const char *pattern, size_t begin, size_t end)
+        {
+            return end - begin == 0 ? end
+                : end - begin == 1 ? (pattern[begin] == '{' || pattern[begin] == '}' ? begin : end)
+                : find_brace_after(pattern, find_brace(pattern, begin, begin + (end - begin) / 2), begin + (end - begin) / 2, end);
+        }
+
+        constexpr const char *find_spec_end(const char *p)
+        {
+            return *p == '\0' || *p == '}' ? p : find_spec_end(p + 1);
+        }
+
+        constexpr const char *skip_spec_flags(const char *p, const char *end)
+        {
+            return p != end && contains("-0+ #'", *p) ? skip_spec_flags(p + 1, end) : p;
+        }
+
+        constexpr const char *skip_spec_precision(const char *p, const char *end)
+        {
+            return p != end && *p == '.' ? skip_digits(p + 1) : p;
+        }
+
+        constexpr const char *skip_spec_length(const char *p, const char *end)
+        {
+            return p == end ? p
+                : (*p == 'h' || *p == 'l') ? (p + 1 != end && p[1] == *p ? p + 2 : p + 1)
+                : contains("jztL", *p) ? p + 1
+                : p;
+        }
+
+        /// Conversion type at p if it is the last character of specification, 0 if there is no type, -1 if specification is invalid
+        constexpr int spec_type(const char *p, const char *end)
+        {
+            return p == end ? 0
+                : p + 1 == end && contains("diuoxXcspfFeEgG", *p) ? *p
+                : -1;
+        }
+
+        /// Conversion type of specification [begin, end), see spec_type
+        constexpr int parse_pattern_spec(const char *begin, const char *end)
+        {
+            return spec_type(skip_spec_length(skip_spec_precision(skip_digits(skip_spec_flags(
+                end - begin >= 2 && contains("<>^", begin[1]) ? begin + 2
+                : begin != end && contains("<>^", *begin) ? begin + 1
+                : begin, end)), end), end), end);
+        }
+
+        constexpr bool conversion_allowed(const char *conversions, int type)
+        {
+            return type == 0 || conversions == nullptr || contains(conversions, char(type));
+        }
+
+        template <class Arguments, size_t N>
+        constexpr pattern_check check_pattern_text(const char (&pattern)[N], size_t position, size_t nextArgument, Arguments arguments);
+
+        /// Check field with argument index and specification [specBegin, specEnd)
+        template <class Arguments, size_t N>
+        constexpr pattern_check check_pattern_argument(const char (&pattern)[N], size_t argument, const char *specBegin, const char *specEnd, Arguments arguments)
+        {
+            return *specEnd != '}' ? pattern_malformed
+                : parse_pattern_spec(specBegin, specEnd) < 0 ? pattern_malformed
+                : argument >= arguments_count(arguments) ? pattern_missing_argument
+                : !conversion_allowed(argument_conversions(arguments, argument), parse_pattern_spec(specBegin, specEnd)) ? pattern_type_mismatch
+                : check_pattern_text(pattern, size_t(specEnd - pattern) + 1, argument + 1, arguments);
+        }
+
+        /// Check field after '{' and optional argument index
+        template <class Arguments, size_t N>
+        constexpr pattern_check check_pattern_field(const char (&pattern)[N], const char *p, size_t argument, Arguments arguments)
+        {
+            return *p == '}' ? check_pattern_argument(pattern, argument, p, p, arguments)
+                : *p == ':' ? check_pattern_argument(pattern, argument, p + 1, find_spec_end(p + 1), arguments)
+                : pattern_malformed;
+        }
+
+        template <class Arguments, size_t N>
+        constexpr pattern_check check_pattern_brace(const char (&pattern)[N], size_t brace, size_t nextArgument, Arguments arguments)
+        {
+            return brace >= N - 1 ? pattern_valid
+                : pattern[brace] == pattern[brace + 1] ? check_pattern_text(pattern, brace + 2, nextArgument, arguments)
+                : pattern[brace] == '}' ? pattern_malformed
+                : is_pattern_digit(pattern[brace + 1])
+                    ? check_pattern_field(pattern, skip_digits(pattern + brace + 1), parse_pattern_index(pattern + brace + 1, 0), arguments)
+                    : check_pattern_field(pattern, pattern + brace + 1, nextArgument, arguments);
+        }
+
+        template <class Arguments, size_t N>
+        constexpr pattern_check check_pattern_text(const char (&pattern)[N], size_t position, size_t nextArgument, Arguments arguments)
+        {
+            return check_pattern_brace(pattern, find_brace(pattern, position, N - 1), nextArgument, arguments);
+        }
+
+        /// \brief Check format pattern literal against types of arguments.
+        template <class Arguments, size_t N>
+        constexpr pattern_check check_pattern(const char (&pattern)[N], Arguments arguments)
+        {
+            return check_pattern_text(pattern, 0, 0, arguments);
+        }
+    }
+}
+
+#define STRINGS_CHECK_PATTERN(pattern, arguments) \
+    static_assert(::strings::detail::check_pattern(pattern, arguments()) != ::strings::detail::pattern_malformed, \
+                  "format pattern is malformed"); \
+    static_assert(::strings::detail::check_pattern(pattern, arguments()) != ::strings::detail::pattern_missing_argument, \
+                  "format pattern refers to missing argument"); \
+    static_assert(::strings::detail::check_pattern(pattern, arguments()) != ::strings::detail::pattern_type_mismatch, \
+                  "format pattern conversion doesn't match argument type")
+
+/// \brief Format arguments according to pattern literal checked at compile time and append result to sink.
+/// \return count of characters appended to sink
+#define STRINGS_FORMAT_TO(sink, pattern, ...) \
+    ([&]() -> size_t { \
+        typedef decltype(::strings::detail::pattern_arguments_of(__VA_ARGS__)) strings_pattern_arguments; \
+        STRINGS_CHECK_PATTERN(pattern, strings_pattern_arguments); \
+        static const ::strings::compiled_pattern strings_compiled_pattern(pattern); \
+        return ::strings::format_to(sink, strings_compiled_pattern, __VA_ARGS__); \
+    }())
+
+#else
+
+#define STRINGS_FORMAT_TO(sink, pattern, ...) ::strings::format_to(sink, pattern, __VA_ARGS__)
+
+#endif
+
+/// \brief Format arguments according to pattern literal checked at compile time into new string.
+#define STRINGS_FORMAT(pattern, ...) \
+    ([&]() -> std::string { \
+        std::string strings_formatted; \
+        STRINGS_FORMAT_TO(strings_formatted, pattern, __VA_ARGS__); \
+        return strings_formatted; \
+    }())
+
+#endif
@@ -0,0 +1,188 @@
+#include "deferred_format.h"
+#include <platform/thread_functions.h>
+#include <stdexcept>
+
+namespace strings
+{
+    namespace
+    {
+        const size_t pattern_chunk_size = 256;
+        const size_t max_pattern_chunks = 1024;
+
+        /// Patterns are never moved after registration, so they are read without lock
+        struct pattern_registry
+        {
+            std::mutex mutex;
+            std::atomic<size_t> count;
+            std::atomic<const char **> chunks[max_pattern_chunks];
+        };
+
+        pattern_registry &get_pattern_registry()
+        {
+            static pattern_registry registry;
+            return registry;
+        }
+
+        size_t round_capacity(size_t capacity)
+        {
+            size_t result = 64;
+            while (result < capacity)
+                result <<= 1;
+            return result;
+        }
+    }
+
+    pattern_id register_pattern(const char *pattern)
+    {
+        pattern_registry &registry = get_pattern_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        size_t index = registry.count.load(std::memory_order_relaxed);
+        if (index == pattern_chunk_size * max_pattern_chunks)
+            throw std::length_error("deferred format: too many patterns");
+
+        const char **chunk = registry.chunks[index / pattern_chunk_size].load(std::memory_order_relaxed);
+        if (chunk == nullptr)
+        {
+            chunk = new const char *[pattern_chunk_size];
+            registry.chunks[index / pattern_chunk_size].store(chunk, std::memory_order_relaxed);
+        }
+        chunk[index % pattern_chunk_size] = pattern;
+        registry.count.store(index + 1, std::memory_order_release);
+        return pattern_id(index);
+    }
+
+    const char *registered_pattern(pattern_id pattern)
+    {
+        pattern_registry &registry = get_pattern_registry();
+        if (pattern >= registry.count.load(std::memory_order_acquire))
+            throw std::out_of_range("deferred format: pattern is not registered");
+        return registry.chunks[pattern / pattern_chunk_size].load(std::memory_order_relaxed)[pattern % pattern_chunk_size];
+    }
+
+    deferred_buffer::deferred_buffer(size_t capacity)
+        : _storage(new char[round_capacity(capacity) + 15])
+        , _data(_storage.get() + (16 - reinterpret_cast<uintptr_t>(_storage.get()) % 16) % 16)
+        , _mask(round_capacity(capacity) - 1)
+        , _head(0)
+        , _tail(0)
+        , _dropped(0)
+    {
+    }
+
+    char *deferred_buffer::reserve(size_t size)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        size_t offset = head & _mask;
+        size_t tillEnd = capacity() - offset;
+        size_t required = size <= tillEnd ? size : size + tillEnd;
+        if (size > capacity() || capacity() - (head - tail) < required)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        if (size > tillEnd)
+        {
+            detail::deferred_record padding = { uint32_t(tillEnd), detail::deferred_padding, 0, 0 };
+            memcpy(_data + offset, &padding, sizeof(padding));
+            _head.store(head + tillEnd, std::memory_order_release);
+            offset = 0;
+        }
+        return _data + offset;
+    }
+
+    void deferred_buffer::commit(size_t size)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    const detail::deferred_record *deferred_buffer::front()
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            if (tail == _head.load(std::memory_order_acquire))
+                return nullptr;
+
+            const detail::deferred_record *record = reinterpret_cast<const detail::deferred_record *>(_data + (tail & _mask));
+            if (record->pattern != detail::deferred_padding)
+                return record;
+
+            tail += record->size;
+            _tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    void deferred_buffer::pop(const detail::deferred_record *record)
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+    }
+
+    deferred_formatter::deferred_formatter(size_t bufferCapacity)
+        : _bufferCapacity(bufferCapacity)
+        , _slotsCount(0)
+    {
+        for (size_t i = 0; i < max_buffer_chunks; ++i)
+            _chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    deferred_formatter::~deferred_formatter()
+    {
+        for (size_t i = 0; i < max_buffer_chunks; ++i)
+        {
+            std::atomic<deferred_buffer *> *chunk = _chunks[i].load(std::memory_order_relaxed);
+            if (chunk == nullptr)
+                continue;
+            for (size_t j = 0; j < buffer_chunk_size; ++j)
+                delete chunk[j].load(std::memory_order_relaxed);
+            delete[] chunk;
+        }
+    }
+
+    size_t deferred_formatter::dropped() const
+    {
+        size_t result = 0;
+        for (size_t slot = 0; slot < slots_count(); ++slot)
+        {
+            const deferred_buffer *buffer = slot_buffer(slot);
+            if (buffer != nullptr)
+                result += buffer->dropped();
+        }
+        return result;
+    }
+
+    deferred_buffer *deferred_formatter::slot_buffer(size_t slot) const
+    {
+        std::atomic<deferred_buffer *> *chunk = _chunks[slot / buffer_chunk_size].load(std::memory_order_acquire);
+        return chunk != nullptr ? chunk[slot % buffer_chunk_size].load(std::memory_order_acquire) : nullptr;
+    }
+
+    deferred_buffer &deferred_formatter::thread_buffer()
+    {
+        size_t slot = platform::current_thread_slot();
+        if (slot >= buffer_chunk_size * max_buffer_chunks)
+            throw std::length_error("deferred format: too many threads");
+
+        deferred_buffer *buffer = slot_buffer(slot);
+        if (buffer != nullptr)
+            return *buffer;
+
+        std::lock_guard<std::mutex> lock(_chunksMutex);
+        std::atomic<deferred_buffer *> *chunk = _chunks[slot / buffer_chunk_size].load(std::memory_order_relaxed);
+        if (chunk == nullptr)
+        {
+            chunk = new std::atomic<deferred_buffer *>[buffer_chunk_size];
+            for (size_t i = 0; i < buffer_chunk_size; ++i)
+                chunk[i].store(nullptr, std::memory_order_relaxed);
+            _chunks[slot / buffer_chunk_size].store(chunk, std::memory_order_release);
+        }
+
+        // only thread of slot creates its buffer
+        buffer = new deferred_buffer(_bufferCapacity);
+        chunk[slot % buffer_chunk_size].store(buffer, std::memory_order_release);
+        if (_slotsCount.load(std::memory_order_relaxed) <= slot)
+            _slotsCount.store(slot + 1, std::memory_order_release);
+        return *buffer;
+    }
+}
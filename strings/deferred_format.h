@@ -0,0 +1,315 @@
+#ifndef __DEFERRED_FORMAT_HEADER_H__
+#define __DEFERRED_FORMAT_HEADER_H__
+
+/// \file
+///
+/// Deferred formatting: producer copies raw argument values and pattern ID
+/// into per-thread buffer, consumer renders them to text later with the same formatters.
+///
+/// ~~~{.c}
+/// static const strings::pattern_id orderPattern = strings::register_pattern("{}: {} ({:x})");
+///
+/// strings::deferred_formatter messages;
+///
+/// // producer threads
+/// messages.capture(orderPattern, "order", quantity, flags);
+///
+/// // consumer thread
+/// std::string text;
+/// messages.render(text);
+/// ~~~
+
+#include "format.h"
+#include "formatter.h"
+#include "string_view.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strings
+{
+    /// Identifier of format pattern, registered with register_pattern()
+    typedef uint32_t pattern_id;
+
+    /// \brief Register format pattern for deferred formatting.
+    ///
+    /// Pattern is stored by pointer, so it should live until all messages
+    /// with this pattern are rendered (usually it's string literal).
+    pattern_id register_pattern(const char *pattern);
+
+    /// \brief Get pattern by identifier.
+    /// \throw std::out_of_range if pattern is not registered
+    const char *registered_pattern(pattern_id pattern);
+
+    namespace detail
+    {
+        /// Max count of arguments in deferred message
+        const size_t max_deferred_arguments = 16;
+
+        inline size_t deferred_align(size_t size, size_t alignment)
+        {
+            return (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        template <class T>
+        struct is_deferred_value
+        {
+            static const bool value = std::is_arithmetic<T>::value
+                || std::is_same<T, timestamp>::value
+                || (std::is_pod<T>::value && has_formatter_traits<T>::value);
+        };
+
+        template <class T>
+        struct is_deferred_pointer
+        {
+            static const bool value = std::is_pointer<T>::value
+                && !std::is_same<typename std::remove_cv<typename std::remove_pointer<T>::type>::type, char>::value
+                && !std::is_same<typename std::remove_cv<typename std::remove_pointer<T>::type>::type, wchar_t>::value;
+        };
+
+        /// \brief Serialization of argument for deferred formatting.
+        ///
+        /// Values are copied as is, strings are copied with their characters,
+        /// so captured message doesn't refer to memory of producer.
+        template <class T, class Enable = void>
+        struct deferred_argument;
+
+        template <class T>
+        struct deferred_argument<T, typename std::enable_if<is_deferred_value<T>::value || is_deferred_pointer<T>::value>::type>
+        {
+            static size_t size(const T &) { return sizeof(T); }
+            static void write(char *data, const T &value) { memcpy(data, &value, sizeof(T)); }
+
+            static formatter read(const char *data, size_t)
+            {
+                T value;
+                memcpy(&value, data, sizeof(T));
+                return get_formatter(value);
+            }
+        };
+
+        template <class Char>
+        struct deferred_string
+        {
+            static size_t size(basic_string_view<Char> value) { return value.size() * sizeof(Char); }
+            static void write(char *data, basic_string_view<Char> value) { memcpy(data, value.data(), value.size() * sizeof(Char)); }
+
+            static formatter read(const char *data, size_t size)
+            {
+                return get_formatter(basic_string_view<Char>(reinterpret_cast<const Char *>(data), size / sizeof(Char)));
+            }
+        };
+
+        template <> struct deferred_argument<char *> : deferred_string<char> {};
+        template <> struct deferred_argument<const char *> : deferred_string<char> {};
+        template <> struct deferred_argument<wchar_t *> : deferred_string<wchar_t> {};
+        template <> struct deferred_argument<const wchar_t *> : deferred_string<wchar_t> {};
+        template <size_t N> struct deferred_argument<char[N]> : deferred_string<char> {};
+        template <size_t N> struct deferred_argument<wchar_t[N]> : deferred_string<wchar_t> {};
+        template <class Char> struct deferred_argument<basic_string_view<Char> > : deferred_string<Char> {};
+        template <class Char, class Traits, class Alloc>
+        struct deferred_argument<std::basic_string<Char, Traits, Alloc> > : deferred_string<Char> {};
+
+        /// Header of captured message in deferred buffer
+        struct deferred_record
+        {
+            /// Size of record including header and arguments
+            uint32_t size;
+            pattern_id pattern;
+            uint32_t arguments;
+            uint32_t reserved;
+        };
+
+        /// Pattern of record, which fills the rest of buffer before wrapping to its beginning
+        const pattern_id deferred_padding = UINT32_MAX;
+
+        /// Header of captured argument
+        struct deferred_argument_header
+        {
+            formatter (*read)(const char *data, size_t size);
+            uint64_t size;
+        };
+
+        template <class T>
+        size_t deferred_argument_size(const T &value)
+        {
+            return sizeof(deferred_argument_header) + deferred_align(deferred_argument<T>::size(value), 8);
+        }
+
+        template <class T>
+        char *write_deferred_argument(char *data, const T &value)
+        {
+            deferred_argument_header header = { &deferred_argument<T>::read, deferred_argument<T>::size(value) };
+            memcpy(data, &header, sizeof(header));
+            deferred_argument<T>::write(data + sizeof(header), value);
+            return data + sizeof(header) + deferred_align(size_t(header.size), 8);
+        }
+
+        inline size_t sum() { return 0; }
+
+        template <class... Sizes>
+        size_t sum(size_t first, Sizes... rest) { return first + sum(rest...); }
+    }
+
+    /// \brief Buffer of captured messages with single producer and single consumer.
+    ///
+    /// Producer never blocks and never allocates: if message doesn't fit, it's dropped.
+    class deferred_buffer
+    {
+    public:
+        /// \param capacity - buffer size in bytes, rounded up to power of two
+        explicit deferred_buffer(size_t capacity = 64 * 1024);
+
+        /// \brief Copy pattern identifier and argument values to buffer.
+        /// \return false if buffer is full and message is dropped
+        template <class... Args>
+        bool capture(pattern_id pattern, const Args&... args)
+        {
+            static_assert(sizeof...(Args) <= detail::max_deferred_arguments, "too many arguments for deferred formatting");
+            size_t size = detail::deferred_align(sizeof(detail::deferred_record) + detail::sum(detail::deferred_argument_size(args)...), 16);
+            char *data = reserve(size);
+            if (data == nullptr)
+                return false;
+
+            detail::deferred_record record = { uint32_t(size), pattern, uint32_t(sizeof...(Args)), 0 };
+            memcpy(data, &record, sizeof(record));
+            char *argument = data + sizeof(record);
+            int expand[] = { 0, (argument = detail::write_deferred_argument(argument, args), 0)... };
+            (void)expand;
+            (void)argument;
+            commit(size);
+            return true;
+        }
+
+        /// \brief Render next captured message to sink.
+        /// \return false if there are no messages
+        template <class Sink>
+        bool render(Sink &sink)
+        {
+            const detail::deferred_record *record = front();
+            if (record == nullptr)
+                return false;
+
+            formatter arguments[detail::max_deferred_arguments + 1];
+            const char *argument = reinterpret_cast<const char *>(record + 1);
+            for (uint32_t i = 0; i < record->arguments; ++i)
+            {
+                detail::deferred_argument_header header;
+                memcpy(&header, argument, sizeof(header));
+                argument += sizeof(header);
+                arguments[i] = header.read(argument, size_t(header.size));
+                argument += detail::deferred_align(size_t(header.size), 8);
+            }
+
+            try
+            {
+                detail::format_pattern(sink, registered_pattern(record->pattern), arguments, record->arguments);
+            }
+            catch (...)
+            {
+                pop(record);
+                throw;
+            }
+            pop(record);
+            return true;
+        }
+
+        /// Count of bytes which may be used by messages
+        size_t capacity() const { return _mask + 1; }
+
+        /// Count of messages dropped because buffer was full
+        size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    private:
+        deferred_buffer(const deferred_buffer &) = delete;
+        deferred_buffer &operator=(const deferred_buffer &) = delete;
+
+        char *reserve(size_t size);
+        void commit(size_t size);
+        const detail::deferred_record *front();
+        void pop(const detail::deferred_record *record);
+
+        std::unique_ptr<char[]> _storage;
+        char *_data;
+        size_t _mask;
+        std::atomic<size_t> _head;
+        std::atomic<size_t> _tail;
+        std::atomic<size_t> _dropped;
+    };
+
+    /// \brief Deferred formatting for many producer threads.
+    ///
+    /// Each producer thread gets its own deferred_buffer on first capture.
+    /// Buffers are indexed by thread slot (see platform::current_thread_slot()),
+    /// so capture finds buffer of its thread without lock. Buffer of exited thread
+    /// is used by next thread with the same slot, buffers live until deferred_formatter
+    /// is destroyed. Messages of single thread are rendered in capture order.
+    class deferred_formatter
+    {
+    public:
+        /// \param bufferCapacity - capacity of buffer of each producer thread
+        explicit deferred_formatter(size_t bufferCapacity = 64 * 1024);
+        ~deferred_formatter();
+
+        /// \brief Capture message in buffer of current thread.
+        /// \return false if buffer is full and message is dropped
+        template <class... Args>
+        bool capture(pattern_id pattern, const Args&... args)
+        {
+            return thread_buffer().capture(pattern, args...);
+        }
+
+        /// \brief Render all captured messages to sink, each message is followed by delimiter.
+        /// \return count of rendered messages
+        template <class Sink>
+        size_t render(Sink &sink, char delimiter = '\n')
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            size_t count = 0;
+            for (size_t slot = 0; slot < slots_count(); ++slot)
+            {
+                deferred_buffer *buffer = slot_buffer(slot);
+                while (buffer != nullptr && buffer->render(sink))
+                {
+                    sink.append(&delimiter, 1);
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        /// Count of messages dropped because buffers were full
+        size_t dropped() const;
+
+    private:
+        deferred_formatter(const deferred_formatter &) = delete;
+        deferred_formatter &operator=(const deferred_formatter &) = delete;
+
+        /// Buffer of current thread, created on first capture
+        deferred_buffer &thread_buffer();
+
+        /// Buffer of thread slot or nullptr
+        deferred_buffer *slot_buffer(size_t slot) const;
+
+        /// Upper bound of slots with buffers
+        size_t slots_count() const { return _slotsCount.load(std::memory_order_acquire); }
+
+        static const size_t buffer_chunk_size = 64;
+        static const size_t max_buffer_chunks = 1024;
+
+        const size_t _bufferCapacity;
+        std::atomic<std::atomic<deferred_buffer *> *> _chunks[max_buffer_chunks];
+        std::atomic<size_t> _slotsCount;
+        std::mutex _chunksMutex;
+        mutable std::mutex _mutex;
+    };
+}
+
+#endif
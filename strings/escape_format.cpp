@@ -0,0 +1,194 @@
+#include "escape_format.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define STRINGS_ESCAPE_AVX2
+#define STRINGS_ESCAPE_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STRINGS_ESCAPE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace strings
+{
+    namespace detail
+    {
+        namespace
+        {
+            inline unsigned first_bit(uint32_t mask)
+            {
+#if defined(_MSC_VER)
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return unsigned(index);
+#else
+                return unsigned(__builtin_ctz(mask));
+#endif
+            }
+
+            template <escape_style Style>
+            inline bool needs_escape(unsigned char c)
+            {
+                switch (Style)
+                {
+                case escape_json:
+                    return c < 0x20 || c == '"' || c == '\\';
+                case escape_c:
+                    return c < 0x20 || c == 0x7F || c == '"' || c == '\\';
+                default:
+                    return c == ',' || c == '"' || c == '\r' || c == '\n';
+                }
+            }
+
+#if defined(STRINGS_ESCAPE_SSE2)
+            template <escape_style Style>
+            inline uint32_t escape_mask(__m128i chunk)
+            {
+                __m128i special;
+                if (Style == escape_csv)
+                {
+                    special = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+                }
+                else
+                {
+                    // unsigned comparison: min(c, 0x1F) == c means c <= 0x1F
+                    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk);
+                    special = _mm_or_si128(control,
+                        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+                    if (Style == escape_c)
+                        special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(0x7F)));
+                }
+                return uint32_t(_mm_movemask_epi8(special));
+            }
+#endif
+
+#if defined(STRINGS_ESCAPE_AVX2)
+            template <escape_style Style>
+            inline uint32_t escape_mask(__m256i chunk)
+            {
+                __m256i special;
+                if (Style == escape_csv)
+                {
+                    special = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(',')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))));
+                }
+                else
+                {
+                    __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, _mm256_set1_epi8(0x1F)), chunk);
+                    special = _mm256_or_si256(control,
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))));
+                    if (Style == escape_c)
+                        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(0x7F)));
+                }
+                return uint32_t(_mm256_movemask_epi8(special));
+            }
+#endif
+
+            template <escape_style Style>
+            const char *find_escape(const char *p, const char *end)
+            {
+#if defined(STRINGS_ESCAPE_AVX2)
+                for (; end - p >= 32; p += 32)
+                {
+                    uint32_t mask = escape_mask<Style>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+                    if (mask != 0)
+                        return p + first_bit(mask);
+                }
+#endif
+#if defined(STRINGS_ESCAPE_SSE2)
+                for (; end - p >= 16; p += 16)
+                {
+                    uint32_t mask = escape_mask<Style>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+                    if (mask != 0)
+                        return p + first_bit(mask);
+                }
+#endif
+                for (; p != end; ++p)
+                {
+                    if (needs_escape<Style>(static_cast<unsigned char>(*p)))
+                        return p;
+                }
+                return end;
+            }
+        }
+
+        const char *find_escape(const char *begin, const char *end, escape_style style)
+        {
+            switch (style)
+            {
+            case escape_json: return find_escape<escape_json>(begin, end);
+            case escape_c: return find_escape<escape_c>(begin, end);
+            default: return find_escape<escape_csv>(begin, end);
+            }
+        }
+
+        size_t escape_sequence(char c, escape_style style, char *sequence)
+        {
+            if (style == escape_csv)
+            {
+                sequence[0] = c;
+                if (c != '"')
+                    return 1;
+                sequence[1] = '"';
+                return 2;
+            }
+
+            sequence[0] = '\\';
+            switch (c)
+            {
+            case '"': sequence[1] = '"'; return 2;
+            case '\\': sequence[1] = '\\'; return 2;
+            case '\b': sequence[1] = 'b'; return 2;
+            case '\f': sequence[1] = 'f'; return 2;
+            case '\n': sequence[1] = 'n'; return 2;
+            case '\r': sequence[1] = 'r'; return 2;
+            case '\t': sequence[1] = 't'; return 2;
+            }
+
+            unsigned char code = static_cast<unsigned char>(c);
+            if (style == escape_json)
+            {
+                static const char hex[] = "0123456789abcdef";
+                memcpy(sequence + 1, "u00", 3);
+                sequence[4] = hex[code >> 4];
+                sequence[5] = hex[code & 0xF];
+                return 6;
+            }
+
+            switch (c)
+            {
+            case '\a': sequence[1] = 'a'; return 2;
+            case '\v': sequence[1] = 'v'; return 2;
+            }
+            // octal escape has at most 3 digits, so following digits are not consumed by it
+            sequence[1] = char('0' + (code >> 6));
+            sequence[2] = char('0' + ((code >> 3) & 7));
+            sequence[3] = char('0' + (code & 7));
+            return 4;
+        }
+    }
+
+    size_t escaped_str_format(char *buffer, size_t bufferSize, const format_spec &spec, const escaped_string &value)
+    {
+        if (buffer != nullptr && bufferSize == 0)
+            return 0;
+
+        detail::formatter_sink sink(buffer, bufferSize);
+        append_escaped(sink, value.value, value.style);
+        return detail::pad_in_place(buffer, bufferSize, sink.finish(), spec);
+    }
+
+    size_t escaped_str_format(char *buffer, size_t bufferSize, const format_options *format, const escaped_string &value)
+    {
+        return escaped_str_format(buffer, bufferSize, format != nullptr ? format->get_spec() : default_format_spec(), value);
+    }
+}
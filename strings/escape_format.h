@@ -0,0 +1,119 @@
+#ifndef __ESCAPE_FORMAT_HEADER_H__
+#define __ESCAPE_FORMAT_HEADER_H__
+
+/// \file
+///
+/// Escaping of strings for JSON, C literals and CSV fields.
+///
+/// Strings are scanned 16 or 32 bytes at a time (SSE2 or AVX2 if compiler targets it)
+/// for characters which need escaping, clean runs between them are copied at once.
+///
+/// ~~~{.c}
+/// strings::format_to(sink, "{{\"user\":\"{}\"}}", strings::json_escaped(name));
+/// strings::append_escaped(sink, name, strings::escape_csv);
+/// ~~~
+
+#include "formatter.h"
+#include "string_view.h"
+#include <cstddef>
+#include <cstring>
+
+namespace strings
+{
+    enum escape_style
+    {
+        escape_json,    ///< contents of JSON string: \c \" \c \\ and control characters
+        escape_c,       ///< contents of C string literal: quotes, backslash, control characters and DEL
+        escape_csv      ///< CSV field, quoted (with doubled quotes) if it contains comma, quote or line break
+    };
+
+    /// \brief Reference to string, which is escaped when formatted.
+    ///
+    /// Doesn't own characters, like string_view.
+    struct escaped_string
+    {
+        string_view value;
+        escape_style style;
+    };
+
+    inline escaped_string json_escaped(string_view value) { escaped_string result = { value, escape_json }; return result; }
+    inline escaped_string c_escaped(string_view value) { escaped_string result = { value, escape_c }; return result; }
+    inline escaped_string csv_quoted(string_view value) { escaped_string result = { value, escape_csv }; return result; }
+
+    /// \brief Format escaped string.
+    ///
+    /// Field width and alignment are applied to escaped text, precision is ignored.
+    size_t escaped_str_format(char *buffer, size_t bufferSize, const format_spec &spec, const escaped_string &value);
+    size_t escaped_str_format(char *buffer, size_t bufferSize, const format_options *format, const escaped_string &value);
+
+    namespace detail
+    {
+        /// \brief Find first character, which should be escaped.
+        ///
+        /// For escape_csv finds first character, which requires quoting of field.
+        const char *find_escape(const char *begin, const char *end, escape_style style);
+
+        /// \brief Write escape sequence of character to buffer of at least 8 characters.
+        /// \return length of escape sequence
+        size_t escape_sequence(char c, escape_style style, char *sequence);
+
+        struct escaped_string_traits
+        {
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const escaped_string &value)
+            {
+                return escaped_str_format(buffer, bufferSize, format, value);
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_spec &spec, const escaped_string &value)
+            {
+                return escaped_str_format(buffer, bufferSize, spec, value);
+            }
+        };
+    }
+
+    inline formatter get_formatter(const escaped_string &value) {
+        return formatter::create<detail::escaped_string_traits>(value);
+    }
+
+    /// \brief Append escaped string to sink, clean runs of characters are appended without copying.
+    template <class Sink>
+    void append_escaped(Sink &sink, string_view value, escape_style style)
+    {
+        const char *p = value.data();
+        const char *end = p + value.size();
+        if (style == escape_csv)
+        {
+            if (detail::find_escape(p, end, style) == end)
+            {
+                sink.append(p, value.size());
+                return;
+            }
+
+            sink.append("\"", 1);
+            for (const char *quote; (quote = static_cast<const char *>(memchr(p, '"', size_t(end - p)))) != nullptr; p = quote + 1)
+            {
+                // quote is doubled
+                sink.append(p, size_t(quote - p) + 1);
+                sink.append("\"", 1);
+            }
+            sink.append(p, size_t(end - p));
+            sink.append("\"", 1);
+            return;
+        }
+
+        for (;;)
+        {
+            const char *special = detail::find_escape(p, end, style);
+            if (special != p)
+                sink.append(p, size_t(special - p));
+            if (special == end)
+                break;
+
+            char sequence[8];
+            sink.append(sequence, detail::escape_sequence(*special, style, sequence));
+            p = special + 1;
+        }
+    }
+}
+
+#endif
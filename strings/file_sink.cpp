@@ -0,0 +1,101 @@
+#include "file_sink.h"
+
+#if defined(PLATFORM_LINUX)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/uio.h>
+
+namespace strings
+{
+    file_sink::file_sink(KennyKerr::file_descriptor descriptor, flush_policy policy, size_t bufferSize, size_t flushSize)
+        : _descriptor(std::move(descriptor))
+        , _buffer(std::max<size_t>(bufferSize, 1))
+        , _buffered(0)
+        , _flushSize(flushSize != 0 ? std::min(flushSize, _buffer.size()) : _buffer.size())
+        , _size(0)
+        , _policy(policy)
+        , _error(0)
+    {
+    }
+
+    file_sink::~file_sink()
+    {
+        flush();
+    }
+
+    void file_sink::append(const char_t *source, size_t sourceSize)
+    {
+        _size += sourceSize;
+        if (sourceSize > _buffer.size() - _buffered)
+        {
+            // large content is written together with buffered one without copying
+            if (sourceSize >= _buffer.size() / 2)
+            {
+                write(source, sourceSize);
+                return;
+            }
+
+            size_t count = _buffer.size() - _buffered;
+            memcpy(_buffer.data() + _buffered, source, count);
+            _buffered += count;
+            write(nullptr, 0);
+            source += count;
+            sourceSize -= count;
+        }
+
+        memcpy(_buffer.data() + _buffered, source, sourceSize);
+        _buffered += sourceSize;
+        if (_buffered == _buffer.size()
+            || (_policy == flush_on_size && _buffered >= _flushSize)
+            || (_policy == flush_on_newline && memchr(source, '\n', sourceSize) != nullptr))
+        {
+            write(nullptr, 0);
+        }
+    }
+
+    bool file_sink::flush()
+    {
+        return _buffered == 0 || write(nullptr, 0);
+    }
+
+    bool file_sink::write(const char_t *source, size_t sourceSize)
+    {
+        iovec vectors[2] = { { _buffer.data(), _buffered }, { const_cast<char_t *>(source), sourceSize } };
+        iovec *first = _buffered != 0 ? vectors : vectors + 1;
+        iovec *last = vectors + (sourceSize != 0 ? 2 : 1);
+        _buffered = 0;
+        if (_error != 0)
+            return false;
+
+        while (first != last)
+        {
+            ssize_t written = ::writev(_descriptor.get(), first, int(last - first));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                // including EAGAIN: descriptor is expected to be blocking
+                _error = errno;
+                return false;
+            }
+
+            // skip written part after partial write
+            size_t remaining = size_t(written);
+            while (first != last && remaining >= first->iov_len)
+            {
+                remaining -= first->iov_len;
+                ++first;
+            }
+            if (first != last)
+            {
+                first->iov_base = static_cast<char *>(first->iov_base) + remaining;
+                first->iov_len -= remaining;
+            }
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __FILE_SINK_HEADER_H__
+#define __FILE_SINK_HEADER_H__
+
+/// \file
+///
+/// Buffered sink over POSIX file descriptor.
+///
+/// Formatted output is collected in internal buffer and written with single
+/// system call per buffer instead of call per message:
+///
+/// ~~~{.c}
+/// strings::file_sink log(KennyKerr::file_descriptor(open("app.log", O_WRONLY | O_CREAT | O_APPEND, 0644)));
+/// strings::format_to(log, "{}: {}\n", timestamp, message);
+/// ~~~
+
+#include <platform/handle.hpp>
+#include <cstddef>
+#include <vector>
+
+#if defined(PLATFORM_LINUX)
+
+namespace strings
+{
+    /// \brief Sink interface implementation for file descriptor (file, pipe, socket) with internal buffer.
+    ///
+    /// Content, which doesn't fit into buffer, is written together with buffered data
+    /// by single writev call without copying. Write errors don't throw: after error
+    /// content is discarded and error code is available from \ref error().
+    /// Descriptor must be in blocking mode: \c EAGAIN of non-blocking descriptor is
+    /// error as well, sink doesn't wait till descriptor becomes writable.
+    class file_sink
+    {
+    public:
+        typedef char char_t;
+
+        /// When buffered content is written to descriptor (it's always written when buffer is full)
+        enum flush_policy
+        {
+            flush_explicit,     ///< on \ref flush() call and destruction
+            flush_on_size,      ///< when buffered content reaches flush size
+            flush_on_newline    ///< after appending of content with '\n' (line buffering)
+        };
+
+        /// \param descriptor - descriptor owned by sink, it's closed on destruction
+        /// \param policy     - flush policy
+        /// \param bufferSize - size of internal buffer
+        /// \param flushSize  - size of buffered content, which is written for flush_on_size policy (0 means buffer size)
+        explicit file_sink(KennyKerr::file_descriptor descriptor, flush_policy policy = flush_on_size,
+                           size_t bufferSize = 64 * 1024, size_t flushSize = 0);
+        ~file_sink();
+
+        void reserve(size_t) {}
+
+        void append(const char_t *source, size_t sourceSize);
+
+        /// Count of all characters appended to sink
+        size_t size() const { return _size; }
+
+        /// \brief Write buffered content to descriptor.
+        /// \return false if write failed
+        bool flush();
+
+        /// errno of failed write, 0 if all writes succeeded
+        int error() const { return _error; }
+
+        int descriptor() const { return _descriptor.get(); }
+
+    private:
+        file_sink(const file_sink &) = delete;
+        file_sink &operator=(const file_sink &) = delete;
+
+        /// Write buffered content followed by source with single writev call
+        bool write(const char_t *source, size_t sourceSize);
+
+        KennyKerr::file_descriptor _descriptor;
+        std::vector<char_t> _buffer;
+        size_t _buffered;
+        size_t _flushSize;
+        size_t _size;
+        flush_policy _policy;
+        int _error;
+    };
+}
+
+#endif
+
+#endif
@@ -0,0 +1,149 @@
+#include "format.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace strings
+{
+    namespace detail
+    {
+        namespace
+        {
+            void throw_malformed(const char *message)
+            {
+                throw std::invalid_argument(std::string("format pattern: ") + message);
+            }
+        }
+
+        bool next_pattern_field(const char *&pattern, size_t &nextArgument, pattern_field &field)
+        {
+            const char *p = pattern;
+            if (*p == '\0')
+                return false;
+
+            field.text = p;
+            field.argument = no_argument;
+            while (*p != '\0' && *p != '{' && *p != '}')
+                ++p;
+            field.textSize = size_t(p - field.text);
+
+            if (*p == '\0')
+            {
+                pattern = p;
+                return true;
+            }
+
+            if (p[0] == p[1])
+            {
+                // escaped brace is written as part of literal text
+                ++field.textSize;
+                pattern = p + 2;
+                return true;
+            }
+
+            if (*p == '}')
+                throw_malformed("unmatched '}'");
+
+            ++p;
+            if (*p == '}')
+            {
+                // most common field "{}" doesn't need specification parsing
+                field.argument = nextArgument++;
+                field.spec = default_format_spec();
+                pattern = p + 1;
+                return true;
+            }
+
+            if (*p >= '0' && *p <= '9')
+            {
+                size_t argument = 0;
+                while (*p >= '0' && *p <= '9')
+                    argument = argument * 10 + size_t(*p++ - '0');
+                field.argument = argument;
+            }
+            else
+            {
+                field.argument = nextArgument;
+            }
+            nextArgument = field.argument + 1;
+
+            const char *specBegin = p;
+            if (*p == ':')
+                ++specBegin;
+            else if (*p != '}')
+                throw_malformed("invalid argument index");
+
+            const char *specEnd = specBegin;
+            while (*specEnd != '\0' && *specEnd != '}')
+                ++specEnd;
+            if (*specEnd == '\0')
+                throw_malformed("unmatched '{'");
+
+            if (!parse_format_spec(specBegin, specEnd, field.spec))
+                throw_malformed("invalid format specification");
+
+            pattern = specEnd + 1;
+            return true;
+        }
+
+        size_t measure_pattern(const char *pattern, size_t nextArgument, formatter *arguments, size_t argumentsCount)
+        {
+            size_t size = 0;
+            pattern_field field;
+            while (next_pattern_field(pattern, nextArgument, field))
+            {
+                size += field.textSize;
+                if (field.argument == no_argument)
+                    continue;
+                if (field.argument >= argumentsCount)
+                    throw_argument_out_of_range(field.argument, argumentsCount);
+                size += arguments[field.argument].size(field.spec);
+            }
+            return size;
+        }
+
+        size_t measure_fields(const pattern_field *fields, size_t count, formatter *arguments)
+        {
+            size_t size = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                size += fields[i].textSize;
+                if (fields[i].argument != no_argument)
+                    size += arguments[fields[i].argument].size(fields[i].spec);
+            }
+            return size;
+        }
+
+        void throw_argument_out_of_range(size_t argument, size_t argumentsCount)
+        {
+            throw std::invalid_argument("format pattern: argument " + std::to_string(argument) +
+                " is out of range, there are " + std::to_string(argumentsCount) + " arguments");
+        }
+    }
+}
+
+// compiled patterns
+namespace strings
+{
+    compiled_pattern::compiled_pattern(const char *pattern)
+        : _arguments(0)
+    {
+        size_t nextArgument = 0;
+        detail::pattern_field field;
+        while (detail::next_pattern_field(pattern, nextArgument, field))
+        {
+            if (field.argument != detail::no_argument)
+                _arguments = std::max(_arguments, field.argument + 1);
+            _fields.push_back(field);
+        }
+    }
+}
+
+// type-erased sink
+namespace strings
+{
+    size_t vformat_to(any_sink &sink, const char *pattern, formatter *arguments, size_t argumentsCount)
+    {
+        return detail::format_pattern(sink, pattern, arguments, argumentsCount);
+    }
+}
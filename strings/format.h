@@ -0,0 +1,353 @@
+#ifndef __FORMAT_HEADER_H__
+#define __FORMAT_HEADER_H__
+
+/// \file
+///
+/// Variadic formatting of patterns like "{}: {} ({:x})" into sinks (see sinks.h).
+///
+/// Replacement field syntax is \c {[index][:spec]}, where index is zero-based argument number
+/// (next argument is used if omitted) and spec is optional fill and alignment followed by
+/// printf conversion without leading '%', e.g. \c {:<10s} or \c {:*^8} (see parse_format_spec).
+/// \c {{ and \c }} are written as literal braces.
+
+#include "formatter.h"
+#include "sinks.h"
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace strings
+{
+    namespace detail
+    {
+        /// Part of format pattern: literal text optionally followed by replacement field
+        struct pattern_field
+        {
+            const char *text;
+            size_t textSize;
+            size_t argument;
+            format_spec spec;
+        };
+
+        /// Value of pattern_field::argument if there is no replacement field after text
+        const size_t no_argument = size_t(-1);
+
+        /// Size of stack buffer where formatted text is collected before it is appended to sink
+        const size_t pattern_buffer_size = 256;
+
+        /// \brief Parse next part of format pattern and move pattern pointer after it.
+        /// \param nextArgument index of argument for field without explicit index
+        /// \return false if there is nothing left in pattern
+        /// \throw std::invalid_argument if pattern is malformed
+        bool next_pattern_field(const char *&pattern, size_t &nextArgument, pattern_field &field);
+
+        /// \throw std::invalid_argument
+        void throw_argument_out_of_range(size_t argument, size_t argumentsCount);
+
+        /// \brief Count of characters required to format rest of pattern.
+        /// \throw std::invalid_argument if pattern is malformed or refers to missing argument
+        size_t measure_pattern(const char *pattern, size_t nextArgument, formatter *arguments, size_t argumentsCount);
+
+        /// Collects formatted text in stack buffer, so sink receives few large appends
+        template <class Sink>
+        class pattern_writer
+        {
+        public:
+            explicit pattern_writer(Sink &sink)
+                : _sink(sink)
+                , _size(0)
+            {}
+
+            size_t size() const { return _size; }
+
+            /// Write text to stack buffer, return false if there is not enough room
+            bool try_write(const char *text, size_t textSize)
+            {
+                if (textSize > pattern_buffer_size - _size)
+                    return false;
+                memcpy(_buffer + _size, text, textSize);
+                _size += textSize;
+                return true;
+            }
+
+            /// Format value to stack buffer, return false if there is not enough room
+            bool try_write(formatter &value, const format_spec &spec)
+            {
+                // formatter always writes terminating zero, so length + 1 == available means truncation is possible
+                size_t length = value.format(_buffer + _size, pattern_buffer_size - _size, spec);
+                if (_size + length + 1 >= pattern_buffer_size)
+                    return false;
+                _size += length;
+                return true;
+            }
+
+            /// Write text which doesn't fit to stack buffer, buffer should be flushed before
+            void write(const char *text, size_t textSize)
+            {
+                if (!try_write(text, textSize))
+                    _sink.append(text, textSize);
+            }
+
+            /// Format value which doesn't fit to stack buffer, buffer should be flushed before
+            void write(formatter &value, const format_spec &spec)
+            {
+                if (try_write(value, spec))
+                    return;
+                std::vector<char> heapBuffer(value.size(spec) + 1);
+                size_t length = value.format(heapBuffer.data(), heapBuffer.size(), spec);
+                _sink.append(heapBuffer.data(), length);
+            }
+
+            void flush()
+            {
+                if (_size != 0)
+                    _sink.append(_buffer, _size);
+                _size = 0;
+            }
+
+        private:
+            Sink &_sink;
+            size_t _size;
+            char _buffer[pattern_buffer_size];
+        };
+
+        template <class Sink>
+        size_t format_pattern(Sink &sink, const char *pattern, formatter *arguments, size_t argumentsCount)
+        {
+            size_t initialSize = sink.size();
+            size_t nextArgument = 0;
+            bool reserved = false;
+            pattern_field field;
+            pattern_writer<Sink> writer(sink);
+            for (;;)
+            {
+                const char *rest = pattern;
+                size_t restArgument = nextArgument;
+                if (!next_pattern_field(pattern, nextArgument, field))
+                    break;
+                if (field.argument != no_argument && field.argument >= argumentsCount)
+                    throw_argument_out_of_range(field.argument, argumentsCount);
+
+                bool textWritten = writer.try_write(field.text, field.textSize);
+                if (textWritten && (field.argument == no_argument || writer.try_write(arguments[field.argument], field.spec)))
+                    continue;
+
+                // output doesn't fit to stack buffer: measure the rest of pattern,
+                // so sink is reserved only once, and write directly
+                if (!reserved)
+                {
+                    size_t remaining = measure_pattern(rest, restArgument, arguments, argumentsCount);
+                    if (textWritten)
+                        remaining -= field.textSize;
+                    sink.reserve(sink.size() + writer.size() + remaining);
+                    reserved = true;
+                }
+                writer.flush();
+                if (!textWritten)
+                    writer.write(field.text, field.textSize);
+                if (field.argument != no_argument)
+                    writer.write(arguments[field.argument], field.spec);
+            }
+            writer.flush();
+            return sink.size() - initialSize;
+        }
+    }
+
+    /// \brief Format pattern, which is parsed once and then used without parsing.
+    ///
+    /// Fields refer to text of pattern, so pattern should live as long as compiled_pattern
+    /// (usually it's string literal and compiled_pattern is static, see checked_format.h).
+    ///
+    /// ~~~{.c}
+    /// static const strings::compiled_pattern pattern("{}: {} ({:x})");
+    /// strings::format_to(text, pattern, "value", 42, 42);
+    /// ~~~
+    class compiled_pattern
+    {
+    public:
+        /// \throw std::invalid_argument if pattern is malformed
+        explicit compiled_pattern(const char *pattern);
+
+        const detail::pattern_field *fields() const { return _fields.empty() ? nullptr : &_fields[0]; }
+        size_t size() const { return _fields.size(); }
+
+        /// Count of arguments used by pattern (max argument index + 1)
+        size_t arguments() const { return _arguments; }
+
+    private:
+        std::vector<detail::pattern_field> _fields;
+        size_t _arguments;
+    };
+
+    namespace detail
+    {
+        /// \brief Count of characters required to format compiled fields.
+        size_t measure_fields(const pattern_field *fields, size_t count, formatter *arguments);
+
+        template <class Sink>
+        size_t format_fields(Sink &sink, const compiled_pattern &pattern, formatter *arguments, size_t argumentsCount)
+        {
+            if (pattern.arguments() > argumentsCount)
+                throw_argument_out_of_range(pattern.arguments() - 1, argumentsCount);
+
+            size_t initialSize = sink.size();
+            bool reserved = false;
+            const pattern_field *fields = pattern.fields();
+            pattern_writer<Sink> writer(sink);
+            for (size_t i = 0; i < pattern.size(); ++i)
+            {
+                const pattern_field &field = fields[i];
+                bool textWritten = writer.try_write(field.text, field.textSize);
+                if (textWritten && (field.argument == no_argument || writer.try_write(arguments[field.argument], field.spec)))
+                    continue;
+
+                if (!reserved)
+                {
+                    size_t remaining = measure_fields(fields + i, pattern.size() - i, arguments);
+                    if (textWritten)
+                        remaining -= field.textSize;
+                    sink.reserve(sink.size() + writer.size() + remaining);
+                    reserved = true;
+                }
+                writer.flush();
+                if (!textWritten)
+                    writer.write(field.text, field.textSize);
+                if (field.argument != no_argument)
+                    writer.write(arguments[field.argument], field.spec);
+            }
+            writer.flush();
+            return sink.size() - initialSize;
+        }
+
+        /// Size of stack buffer for batch formatting of arrays
+        const size_t array_chunk_size = 4096;
+
+        /// \brief Format values separated with delimiter to buffer, stops before value which doesn't fit.
+        ///
+        /// Defined for all built-in integer types, float and double.
+        /// \param length - length of written text, or size of buffer needed for the first value if nothing is written
+        /// \return count of formatted values
+        template <class T>
+        size_t format_array(char *buffer, size_t bufferSize, const T *values, size_t count,
+                            const char *delimiter, size_t delimiterSize, bool leadingDelimiter,
+                            const format_spec &spec, size_t &length);
+    }
+
+    /// \brief Format array of numbers separated with delimiter and append result to sink.
+    ///
+    /// All values are formatted with the same specification without creating formatters,
+    /// default decimal conversion of integers uses vectorized digit generation (SSE2).
+    /// Text is collected in stack buffer and appended to sink in large chunks.
+    ///
+    /// ~~~{.c}
+    /// std::vector<uint64_t> latencies = ...;
+    /// strings::format_array_to(text, latencies.data(), latencies.size(), ",");
+    /// ~~~
+    ///
+    /// \return count of characters appended to sink
+    template <class Sink, class T>
+    size_t format_array_to(Sink &sink, const T *values, size_t count, const char *delimiter = ", ",
+                           const format_spec &spec = default_format_spec())
+    {
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value && !std::is_same<T, wchar_t>::value,
+                      "format_array_to formats arrays of numbers");
+        typedef typename std::remove_cv<T>::type value_type;
+
+        char buffer[detail::array_chunk_size];
+        size_t delimiterSize = strlen(delimiter);
+        size_t total = 0;
+        size_t done = 0;
+        while (done < count)
+        {
+            size_t length = 0;
+            size_t formatted = detail::format_array<value_type>(buffer, sizeof(buffer), values + done, count - done,
+                                                                delimiter, delimiterSize, done != 0, spec, length);
+            if (formatted != 0)
+            {
+                sink.append(buffer, length);
+            }
+            else
+            {
+                // value is wider than stack buffer
+                std::vector<char> wide(length);
+                formatted = detail::format_array<value_type>(&wide[0], wide.size(), values + done, 1,
+                                                             delimiter, delimiterSize, done != 0, spec, length);
+                sink.append(&wide[0], length);
+            }
+            total += length;
+            done += formatted;
+        }
+        return total;
+    }
+
+    /// \brief Format arguments according to pattern and append result to sink.
+    ///
+    /// Formatters for arguments are created on stack, so nothing is allocated
+    /// unless single field doesn't fit into 256 characters.
+    /// Text is collected in stack buffer and appended to sink in large chunks.
+    /// If output doesn't fit to stack buffer, size of the rest of output is measured
+    /// (see formatted_size), so sink is reserved only once.
+    ///
+    /// ~~~{.c}
+    /// std::string text;
+    /// strings::format_to(text, "{}: {} ({:x})", "value", 42, 42);   // "value: 42 (2a)"
+    /// ~~~
+    ///
+    /// \return count of characters appended to sink
+    /// \throw std::invalid_argument if pattern is malformed or refers to missing argument
+    template <class Sink, class... Args>
+    size_t format_to(Sink &sink, const char *pattern, const Args&... args)
+    {
+        // last formatter is placeholder, so array is never empty
+        formatter arguments[] = { get_formatter(args)..., formatter() };
+        return detail::format_pattern(sink, pattern, arguments, sizeof...(Args));
+    }
+
+    /// \brief Format formatters according to pattern and append result to type-erased sink.
+    ///
+    /// Non-template entry point for code, which accepts any sink, see \ref any_sink.
+    /// \throw std::invalid_argument if pattern is malformed or refers to missing argument
+    size_t vformat_to(any_sink &sink, const char *pattern, formatter *arguments, size_t argumentsCount);
+
+    /// \brief Format arguments according to compiled pattern and append result to sink.
+    /// \see format_to(Sink &, const char *, const Args&...)
+    /// \throw std::invalid_argument if pattern refers to missing argument
+    template <class Sink, class... Args>
+    size_t format_to(Sink &sink, const compiled_pattern &pattern, const Args&... args)
+    {
+        formatter arguments[] = { get_formatter(args)..., formatter() };
+        return detail::format_fields(sink, pattern, arguments, sizeof...(Args));
+    }
+
+    /// \brief Count of characters which format_to appends to sink for the same pattern and arguments.
+    /// \throw std::invalid_argument if pattern is malformed or refers to missing argument
+    template <class... Args>
+    size_t formatted_size(const char *pattern, const Args&... args)
+    {
+        formatter arguments[] = { get_formatter(args)..., formatter() };
+        return detail::measure_pattern(pattern, 0, arguments, sizeof...(Args));
+    }
+
+    /// \brief Format arguments according to pattern into new string.
+    /// \see format_to
+    template <class... Args>
+    std::string format(const char *pattern, const Args&... args)
+    {
+        std::string result;
+        format_to(result, pattern, args...);
+        return result;
+    }
+
+    /// \brief Format arguments according to compiled pattern into new string.
+    template <class... Args>
+    std::string format(const compiled_pattern &pattern, const Args&... args)
+    {
+        std::string result;
+        format_to(result, pattern, args...);
+        return result;
+    }
+}
+
+#endif
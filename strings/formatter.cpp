@@ -1,93 +1,1665 @@
 #include "formatter.h"
+#include "format.h"
 #include "string_functions.h"
+#include "grisu.h"
+#include "hex_digits.h"
+#include <platform/thread_functions.h>
 #include <boost/nowide/convert.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <cwchar>
+#include <memory>
+#include <string>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STRINGS_FORMATTER_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// format specification
 namespace strings
 {
-    size_t bool_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    namespace detail
     {
-        bool v = (bool)reinterpret_cast<size_t>(value);
-        if (format == nullptr)
+        /// \brief Parse conversion fields [flags][width][.precision][length][type].
+        /// \return pointer to first character which is not part of conversion
+        const char *parse_spec_fields(const char *p, const char *end, format_spec &spec)
         {
-            static const char* bool_values[] = {"false", "true"};
-            const char *bool_str = bool_values[v ? 1 : 0];
-            return string_copy(buffer, bufferSize, bool_str);
+            for (; p != end; ++p)
+            {
+                if (*p == '-') spec.alignment = format_spec::align_left;
+                else if (*p == '0') spec.zero = true;
+                else if (*p == '+') spec.plus = true;
+                else if (*p == ' ') spec.space = true;
+                else if (*p == '#') spec.alternate = true;
+                else if (*p == '\'') spec.localized = true;
+                else break;
+            }
+
+            while (p != end && *p >= '0' && *p <= '9')
+                spec.width = spec.width * 10 + size_t(*p++ - '0');
+
+            if (p != end && *p == '.')
+            {
+                ++p;
+                spec.precision = 0;
+                while (p != end && *p >= '0' && *p <= '9')
+                    spec.precision = spec.precision * 10 + (*p++ - '0');
+            }
+
+            if (p == end)
+                return p;
+            switch (*p)
+            {
+            case 'h':
+                ++p;
+                spec.bits = sizeof(short) * 8;
+                if (p != end && *p == 'h')
+                {
+                    ++p;
+                    spec.bits = sizeof(char) * 8;
+                }
+                break;
+            case 'l':
+                ++p;
+                spec.bits = sizeof(long) * 8;
+                if (p != end && *p == 'l')
+                {
+                    ++p;
+                    spec.bits = sizeof(long long) * 8;
+                }
+                break;
+            case 'j': ++p; spec.bits = sizeof(intmax_t) * 8; break;
+            case 'z': ++p; spec.bits = sizeof(size_t) * 8; break;
+            case 't': ++p; spec.bits = sizeof(ptrdiff_t) * 8; break;
+            case 'L': ++p; break;
+            }
+
+            if (p == end || *p == '\0' || strchr("diuoxXcspfFeEgG", *p) == nullptr)
+                return p;
+            spec.type = *p++;
+            spec.base = spec.type == 'o' ? 8 : (spec.type == 'x' || spec.type == 'X' || spec.type == 'p') ? 16 : 10;
+            spec.upper = strchr("XFEG", spec.type) != nullptr;
+            return p;
         }
-        return str_printf(buffer, bufferSize, format->formatString, v);
     }
 
-    size_t char_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    namespace detail
     {
-        char v = (char)reinterpret_cast<ptrdiff_t>(value);
-        if (format == nullptr)
+        inline bool parse_alignment(char c, format_spec &spec)
+        {
+            switch (c)
+            {
+            case '<': spec.alignment = format_spec::align_left; return true;
+            case '>': spec.alignment = format_spec::align_right; return true;
+            case '^': spec.alignment = format_spec::align_center; return true;
+            default: return false;
+            }
+        }
+    }
+
+    /// \brief Compile printf-like format string to format specification.
+    ///
+    /// Format string should contain exactly one conversion
+    /// \c %[flags][width][.precision][length]type, where flags are any of \c "-+ #0'",
+    /// length is one of \c hh, \c h, \c l, \c ll, \c j, \c z, \c t, \c L
+    /// and type is one of \c diuoxXcspfFeEgG.
+    /// Empty format string means default formatting for value type.
+    ///
+    /// \return false if format string can't be processed natively
+    ///         (\c spec.native is false, and printf should be used instead).
+    bool parse_format_spec(const char *formatString, format_spec &spec)
+    {
+        spec = default_format_spec();
+        if (formatString == nullptr || *formatString == '\0')
+            return true;
+
+        spec.native = false;
+        if (*formatString != '%')
+            return false;
+
+        // without length modifier printf treats integer argument as int
+        spec.bits = sizeof(int) * 8;
+        const char *end = formatString + strlen(formatString);
+        if (detail::parse_spec_fields(formatString + 1, end, spec) != end || spec.type == 0)
+            return false;
+
+        spec.native = true;
+        return true;
+    }
+
+    /// \brief Compile conversion specification without leading '%'.
+    ///
+    /// Syntax is \c [[fill]align][flags][width][.precision][length][type] where all parts are optional,
+    /// e.g. \c "08x", \c "-10s", \c ".3f" or \c "*^12". Alignment is one of \c < (left),
+    /// \c > (right) or \c ^ (center), fill is any character before alignment (space by default).
+    /// Used for replacement fields of format patterns.
+    /// Integer value is formatted as whole unless length modifier is specified.
+    bool parse_format_spec(const char *begin, const char *end, format_spec &spec)
+    {
+        spec = default_format_spec();
+        if (end - begin >= 2 && detail::parse_alignment(begin[1], spec))
+        {
+            spec.fill = begin[0];
+            begin += 2;
+        }
+        else if (begin != end && detail::parse_alignment(*begin, spec))
         {
-            if (bufferSize < 2)
+            ++begin;
+        }
+
+        if (detail::parse_spec_fields(begin, end, spec) != end)
+        {
+            spec.native = false;
+            return false;
+        }
+        return true;
+    }
+
+    /// Format specification for default formatting of value
+    const format_spec &default_format_spec()
+    {
+        static const format_spec spec = { 0, format_spec::align_default, ' ', false, false, false, false, false, 10, 0, 0, -1, true, false };
+        return spec;
+    }
+}
+
+// native formatting helpers
+namespace strings
+{
+    namespace detail
+    {
+        static const char digit_pairs[] =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+
+        /// Write decimal digits of value backward from end, return pointer to first digit
+        inline char *format_decimal(char *end, uint64_t value)
+        {
+            while (value >= 100)
+            {
+                const char *pair = digit_pairs + (value % 100) * 2;
+                value /= 100;
+                *--end = pair[1];
+                *--end = pair[0];
+            }
+            if (value < 10)
+            {
+                *--end = char('0' + value);
+            }
+            else
+            {
+                const char *pair = digit_pairs + value * 2;
+                *--end = pair[1];
+                *--end = pair[0];
+            }
+            return end;
+        }
+
+        /// Write digits of value in power of two base backward from end, return pointer to first digit
+        inline char *format_power_of_two(char *end, uint64_t value, unsigned shift, const char *digits)
+        {
+            const uint64_t mask = (uint64_t(1) << shift) - 1;
+            do
+            {
+                *--end = digits[value & mask];
+                value >>= shift;
+            } while (value != 0);
+            return end;
+        }
+
+        /// Bounded writer, which always leaves room for terminating zero
+        class bounded_writer
+        {
+        public:
+            bounded_writer(char *buffer, size_t bufferSize)
+                : _begin(buffer)
+                , _current(buffer)
+                , _end(buffer + bufferSize - 1)
+            {}
+
+            void fill(char c, size_t count)
+            {
+                count = std::min(count, size_t(_end - _current));
+                memset(_current, c, count);
+                _current += count;
+            }
+
+            void write(const char *source, size_t sourceSize)
+            {
+                sourceSize = std::min(sourceSize, size_t(_end - _current));
+                memcpy(_current, source, sourceSize);
+                _current += sourceSize;
+            }
+
+            size_t finish()
+            {
+                *_current = '\0';
+                return size_t(_current - _begin);
+            }
+
+        private:
+            char *_begin;
+            char *_current;
+            char *_end;
+        };
+
+        inline bool has_type(const format_spec &spec, const char *types)
+        {
+            return spec.type != 0 && strchr(types, spec.type) != nullptr;
+        }
+
+        /// Count of fill characters before value for alignment (extra character of centered value goes after it)
+        inline size_t padding_before(format_spec::alignment_type alignment, size_t padding)
+        {
+            return alignment == format_spec::align_left ? 0
+                : alignment == format_spec::align_center ? padding / 2
+                : padding;
+        }
+
+        inline char fill_char(const format_spec &spec)
+        {
+            return spec.fill != 0 ? spec.fill : ' ';
+        }
+
+        /// \brief Write field: [padding][prefix][zeros][body][padding]
+        /// \param numeric - field may be padded with zeros after prefix (\c spec.zero flag)
+        size_t write_field(char *buffer, size_t bufferSize, const format_spec &spec,
+                           const char *prefix, size_t prefixSize, size_t zeros,
+                           const char *body, size_t bodySize, bool numeric)
+        {
+            size_t length = prefixSize + zeros + bodySize;
+            size_t padding = spec.width > length ? spec.width - length : 0;
+            if (buffer == nullptr)
+                return length + padding;
+            if (bufferSize == 0)
                 return 0;
-            buffer[0] = v;
-            buffer[1] = 0;
-            return 1;
+
+            bool right = spec.alignment == format_spec::align_default || spec.alignment == format_spec::align_right;
+            if (padding != 0 && numeric && spec.zero && right)
+            {
+                zeros += padding;
+                padding = 0;
+            }
+
+            size_t before = padding_before(spec.alignment, padding);
+            char fill = fill_char(spec);
+            bounded_writer writer(buffer, bufferSize);
+            writer.fill(fill, before);
+            writer.write(prefix, prefixSize);
+            writer.fill('0', zeros);
+            writer.write(body, bodySize);
+            writer.fill(fill, padding - before);
+            return writer.finish();
+        }
+
+        /// \brief Apply decimal point and digit grouping of current C locale to formatted number.
+        ///
+        /// Used only for fields with \c ' flag, so native formatting doesn't touch locale data.
+        /// \param group - insert thousands separators into integer part
+        std::string localize_number(const char *text, size_t length, bool group)
+        {
+            const lconv *conventions = localeconv();
+            const char *end = text + length;
+            const char *integerEnd = text;
+            while (integerEnd != end && *integerEnd >= '0' && *integerEnd <= '9')
+                ++integerEnd;
+
+            std::string result;
+            const char *grouping = conventions->grouping;
+            std::string separator(conventions->thousands_sep);
+            if (group && !separator.empty() && grouping != nullptr && *grouping > 0 && *grouping != CHAR_MAX)
+            {
+                // groups are counted from the end of integer part, last group size is repeated
+                std::reverse(separator.begin(), separator.end());
+                size_t groupSize = size_t(*grouping);
+                size_t inGroup = 0;
+                for (const char *p = integerEnd; p != text;)
+                {
+                    if (inGroup == groupSize)
+                    {
+                        result += separator;
+                        inGroup = 0;
+                        if (grouping[1] != 0)
+                            ++grouping;
+                        groupSize = *grouping > 0 && *grouping != CHAR_MAX ? size_t(*grouping) : SIZE_MAX;
+                    }
+                    result += *--p;
+                    ++inGroup;
+                }
+                std::reverse(result.begin(), result.end());
+            }
+            else
+            {
+                result.assign(text, integerEnd);
+            }
+
+            if (integerEnd != end && *integerEnd == '.')
+            {
+                result += conventions->decimal_point;
+                ++integerEnd;
+            }
+            result.append(integerEnd, end);
+            return result;
+        }
+
+        /// \brief Convert wide characters to UTF-8 in single pass.
+        /// \param limit - size of buffer (including terminating zero), conversion stops
+        ///                at first code point which doesn't fit or is invalid, like boost::nowide::narrow does
+        /// \return count of bytes (without terminating zero); if buffer is nullptr, nothing is written
+        size_t narrow(char *buffer, size_t limit, const wchar_t *begin, const wchar_t *end)
+        {
+            size_t length = 0;
+            for (; begin != end; ++begin)
+            {
+                uint32_t c = uint32_t(*begin);
+                if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF)
+                {
+                    // UTF-16 surrogate pair
+                    uint32_t low = begin + 1 != end ? uint32_t(begin[1]) : 0;
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        break;
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    ++begin;
+                }
+                else if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+                {
+                    break;
+                }
+
+                size_t width = c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+                if (limit - 1 - length < width)
+                    break;
+                if (buffer != nullptr)
+                {
+                    char *p = buffer + length;
+                    switch (width)
+                    {
+                    case 1:
+                        p[0] = char(c);
+                        break;
+                    case 2:
+                        p[0] = char(0xC0 | (c >> 6));
+                        p[1] = char(0x80 | (c & 0x3F));
+                        break;
+                    case 3:
+                        p[0] = char(0xE0 | (c >> 12));
+                        p[1] = char(0x80 | ((c >> 6) & 0x3F));
+                        p[2] = char(0x80 | (c & 0x3F));
+                        break;
+                    default:
+                        p[0] = char(0xF0 | (c >> 18));
+                        p[1] = char(0x80 | ((c >> 12) & 0x3F));
+                        p[2] = char(0x80 | ((c >> 6) & 0x3F));
+                        p[3] = char(0x80 | (c & 0x3F));
+                        break;
+                    }
+                }
+                length += width;
+            }
+            if (buffer != nullptr)
+                buffer[length] = '\0';
+            return length;
+        }
+
+        /// Apply field width to text which is already written to buffer
+        size_t pad_in_place(char *buffer, size_t bufferSize, size_t length, const format_spec &spec)
+        {
+            if (buffer == nullptr)
+                return std::max(length, spec.width);
+            if (bufferSize == 0 || spec.width <= length)
+                return length;
+
+            size_t limit = bufferSize - 1;
+            size_t total = std::min(spec.width, limit);
+            size_t before = std::min(padding_before(spec.alignment, spec.width - length), limit);
+            size_t kept = std::min(length, total - before);
+            char fill = fill_char(spec);
+            memmove(buffer + before, buffer, kept);
+            memset(buffer, fill, before);
+            memset(buffer + before + kept, fill, total - before - kept);
+            buffer[total] = '\0';
+            return total;
         }
-        return str_printf(buffer, bufferSize, format->formatString, v);
+    }
+}
+
+// native integer conversion
+namespace strings
+{
+    namespace detail
+    {
+        /// \brief Format integer value according to format specification.
+        /// \param type  - one of d, i, u, o, x, X
+        /// \param value - raw integer bits, interpreted as signed or unsigned
+        ///                depending on type (like printf does)
+        size_t format_integer(char *buffer, size_t bufferSize, const format_spec &spec, char type, uint64_t value)
+        {
+            if (buffer != nullptr && bufferSize == 0)
+                return 0;
+
+            unsigned bits = spec.bits != 0 ? spec.bits : 64;
+            if (bits < 64)
+                value &= (uint64_t(1) << bits) - 1;
+
+            char prefix[2];
+            size_t prefixSize = 0;
+            if (type == 'd' || type == 'i')
+            {
+                // sign-extend value to 64 bits
+                if (bits < 64 && (value >> (bits - 1)) != 0)
+                    value |= ~uint64_t(0) << bits;
+                if (int64_t(value) < 0)
+                {
+                    prefix[prefixSize++] = '-';
+                    value = 0 - value;
+                }
+                else if (spec.plus)
+                    prefix[prefixSize++] = '+';
+                else if (spec.space)
+                    prefix[prefixSize++] = ' ';
+            }
+
+            char digits[24];
+            char *digitsEnd = digits + sizeof(digits);
+            char *first = digitsEnd;
+            if (value != 0 || spec.precision != 0)
+            {
+                switch (type)
+                {
+                case 'o':
+                    first = format_power_of_two(digitsEnd, value, 3, "01234567");
+                    break;
+                case 'x':
+                case 'X':
+                    first = format_hex(digitsEnd, value, hex_digits_count(value), type == 'X');
+                    break;
+                default:
+                    first = format_decimal(digitsEnd, value);
+                    break;
+                }
+            }
+            size_t digitsCount = size_t(digitsEnd - first);
+
+            size_t zeros = 0;
+            if (spec.precision >= 0 && size_t(spec.precision) > digitsCount)
+                zeros = size_t(spec.precision) - digitsCount;
+
+            if (spec.alternate)
+            {
+                if (type == 'o' && zeros == 0 && (digitsCount == 0 || *first != '0'))
+                    zeros = 1;
+                else if ((type == 'x' || type == 'X') && value != 0)
+                {
+                    prefix[prefixSize++] = '0';
+                    prefix[prefixSize++] = type;
+                }
+            }
+
+            if (spec.localized && (type == 'd' || type == 'i' || type == 'u'))
+            {
+                std::string localized = localize_number(first, digitsCount, true);
+                return write_field(buffer, bufferSize, spec, prefix, prefixSize, zeros, localized.data(), localized.size(), spec.precision < 0);
+            }
+            return write_field(buffer, bufferSize, spec, prefix, prefixSize, zeros, first, digitsCount, spec.precision < 0);
+        }
+
+        /// Integer conversions, supported by native integer formatting
+        const char integer_types[] = "diuoxX";
+    }
+}
+
+// native floating point conversion
+namespace strings
+{
+    namespace detail
+    {
+        /// Digits of value are stored as 0.d1d2...dn * 10^point,
+        /// all digits after n-th are zeros.
+        struct decimal_digits
+        {
+            char *digits;
+            int count;
+            int point;
+
+            void trim_zeros()
+            {
+                while (count > 0 && digits[count - 1] == '0')
+                    --count;
+            }
+
+            /// \brief Round digits to specified count of significant digits.
+            /// \return false if digits are exactly in the middle between two
+            ///         rounded values, so rounding needs exact binary value.
+            bool round(int needed)
+            {
+                if (needed >= count)
+                    return true;
+                if (needed < 0)
+                {
+                    count = 0;
+                    return true;
+                }
+
+                char first = digits[needed];
+                if (first == '5')
+                {
+                    bool tie = true;
+                    for (int i = needed + 1; i < count && tie; ++i)
+                        tie = digits[i] == '0';
+                    if (tie)
+                        return false;
+                }
+
+                count = needed;
+                if (first >= '5')
+                {
+                    int i = needed - 1;
+                    while (i >= 0 && digits[i] == '9')
+                        --i;
+                    if (i < 0)
+                    {
+                        digits[0] = '1';
+                        count = 1;
+                        ++point;
+                    }
+                    else
+                    {
+                        ++digits[i];
+                        count = i + 1;
+                    }
+                }
+                trim_zeros();
+                return true;
+            }
+        };
+
+        /// Normalized doubles (floats) rounded up to 15 (6) significant digits
+        /// are always the same as rounded shortest representation.
+        const int exact_shortest_digits = 15;
+        const int exact_shortest_float_digits = 6;
+        /// Max digits after point in exact representation of double is 1074,
+        /// max digits before point is 309. Larger precision is formatted by printf.
+        const int max_exact_precision = 1100;
+        const int max_exact_length = max_exact_precision + 330;
+
+        /// Floating point conversions, supported by native floating point formatting
+        const char floating_point_types[] = "fFeEgG";
+
+        /// Unsigned integer large enough for exact value of any double multiplied by 10^1074
+        class big_integer
+        {
+        public:
+            explicit big_integer(uint64_t value)
+                : _size(0)
+            {
+                for (; value != 0; value >>= 32)
+                    _words[_size++] = uint32_t(value);
+            }
+
+            void multiply(uint32_t factor)
+            {
+                uint64_t carry = 0;
+                for (size_t i = 0; i < _size; ++i)
+                {
+                    carry += uint64_t(_words[i]) * factor;
+                    _words[i] = uint32_t(carry);
+                    carry >>= 32;
+                }
+                if (carry != 0)
+                    _words[_size++] = uint32_t(carry);
+            }
+
+            void multiply_pow5(unsigned exponent)
+            {
+                // 5^13 is the largest power of 5 which fits 32 bits
+                for (; exponent >= 13; exponent -= 13)
+                    multiply(1220703125u);
+                static const uint32_t powers[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625 };
+                multiply(powers[exponent]);
+            }
+
+            void shift_left(unsigned bits)
+            {
+                size_t words = bits / 32;
+                bits %= 32;
+                if (bits != 0)
+                {
+                    uint32_t carry = 0;
+                    for (size_t i = 0; i < _size; ++i)
+                    {
+                        uint32_t word = _words[i];
+                        _words[i] = (word << bits) | carry;
+                        carry = word >> (32 - bits);
+                    }
+                    if (carry != 0)
+                        _words[_size++] = carry;
+                }
+                if (words != 0 && _size != 0)
+                {
+                    memmove(_words + words, _words, _size * sizeof(uint32_t));
+                    memset(_words, 0, words * sizeof(uint32_t));
+                    _size += words;
+                }
+            }
+
+            /// \brief Write decimal digits backward from end, return pointer to first digit.
+            /// Value is destroyed.
+            char *to_decimal(char *end)
+            {
+                char *first = end;
+                while (_size != 0)
+                {
+                    // divide by 10^9
+                    uint64_t remainder = 0;
+                    for (size_t i = _size; i-- > 0;)
+                    {
+                        remainder = (remainder << 32) | _words[i];
+                        _words[i] = uint32_t(remainder / 1000000000u);
+                        remainder %= 1000000000u;
+                    }
+                    while (_size != 0 && _words[_size - 1] == 0)
+                        --_size;
+
+                    char *chunk = format_decimal(first, remainder);
+                    if (_size != 0)
+                    {
+                        // inner chunks always have 9 digits
+                        while (first - chunk < 9)
+                            *--chunk = '0';
+                    }
+                    first = chunk;
+                }
+                return first;
+            }
+
+        private:
+            // 53 bits of mantissa multiplied by 5^1074 (2494 bits)
+            uint32_t _words[80];
+            size_t _size;
+        };
+
+        /// \brief Get exactly rounded digits of positive finite value.
+        ///
+        /// Used only when digits from shortest representation are not enough
+        /// to produce correctly rounded result. Value is converted exactly with big integer
+        /// arithmetic and rounded half to even, like glibc printf does.
+        /// \param conversion - \c f (precision is digits after point) or \c e (precision + 1 significant digits)
+        void exact_digits(double value, char conversion, int precision, decimal_digits &result)
+        {
+            // value = mantissa * 2^exponent
+            int exponent = 0;
+            uint64_t mantissa = uint64_t(std::ldexp(std::frexp(value, &exponent), 53));
+            exponent -= 53;
+            while (mantissa != 0 && (mantissa & 1) == 0)
+            {
+                mantissa >>= 1;
+                ++exponent;
+            }
+
+            // value = number * 10^-scale
+            big_integer number(mantissa);
+            int scale = 0;
+            if (exponent >= 0)
+            {
+                number.shift_left(unsigned(exponent));
+            }
+            else
+            {
+                number.multiply_pow5(unsigned(-exponent));
+                scale = -exponent;
+            }
+
+            char *end = result.digits + max_exact_length;
+            char *first = number.to_decimal(end);
+            int count = int(end - first);
+            memmove(result.digits, first, size_t(count));
+            result.count = count;
+            result.point = count - scale;
+
+            int needed = conversion == 'f' ? result.point + precision : precision + 1;
+            if (needed < count)
+            {
+                bool up = false;
+                if (needed >= 0)
+                {
+                    char next = result.digits[needed];
+                    bool tail = false;
+                    for (int i = needed + 1; i < count && !tail; ++i)
+                        tail = result.digits[i] != '0';
+                    bool odd = needed > 0 && ((result.digits[needed - 1] - '0') & 1) != 0;
+                    up = next > '5' || (next == '5' && (tail || odd));
+                }
+
+                result.count = std::max(needed, 0);
+                if (up)
+                {
+                    int i = needed - 1;
+                    while (i >= 0 && result.digits[i] == '9')
+                        --i;
+                    if (i < 0)
+                    {
+                        // all kept digits are nines (or there are none): result is next power of 10
+                        result.digits[0] = '1';
+                        result.count = 1;
+                        ++result.point;
+                    }
+                    else
+                    {
+                        ++result.digits[i];
+                        result.count = i + 1;
+                    }
+                }
+            }
+            result.trim_zeros();
+            if (result.count == 0)
+                result.point = 1;
+        }
+
+        inline char *write_fixed(char *p, const decimal_digits &d, int precision, bool alternate)
+        {
+            if (d.point <= 0)
+                *p++ = '0';
+            for (int i = 0; i < d.point; ++i)
+                *p++ = i < d.count ? d.digits[i] : '0';
+            if (precision > 0 || alternate)
+                *p++ = '.';
+            for (int i = 0; i < precision; ++i)
+            {
+                int index = d.point + i;
+                *p++ = index >= 0 && index < d.count ? d.digits[index] : '0';
+            }
+            return p;
+        }
+
+        inline char *write_scientific(char *p, const decimal_digits &d, int precision, bool alternate, char e)
+        {
+            *p++ = d.count > 0 ? d.digits[0] : '0';
+            if (precision > 0 || alternate)
+                *p++ = '.';
+            for (int i = 1; i <= precision; ++i)
+                *p++ = i < d.count ? d.digits[i] : '0';
+
+            int exponent = d.count > 0 ? d.point - 1 : 0;
+            *p++ = e;
+            *p++ = exponent < 0 ? '-' : '+';
+            unsigned absExponent = unsigned(exponent < 0 ? -exponent : exponent);
+            if (absExponent < 10)
+                *p++ = '0';
+            char digits[8];
+            char *digitsEnd = digits + sizeof(digits);
+            char *first = format_decimal(digitsEnd, absExponent);
+            memcpy(p, first, size_t(digitsEnd - first));
+            return p + (digitsEnd - first);
+        }
+
+        /// \brief Format positive finite value with printf, when precision is larger than supported natively.
+        ///
+        /// Sign and padding are written like for natively formatted value.
+        size_t printf_double(char *buffer, size_t bufferSize, const format_spec &spec, char sign, double absValue)
+        {
+            format_spec conversion = spec;
+            conversion.plus = false;
+            conversion.space = false;
+            conversion.zero = false;
+            conversion.bits = 0;
+            if (!has_type(spec, floating_point_types))
+                conversion.type = spec.upper ? 'G' : 'g';
+            format_options options = make_format_options(conversion);
+
+            ptrdiff_t size = str_printf_size(options.formatString, absValue);
+            std::string text(size > 0 ? size_t(size) : 0, '\0');
+            if (!text.empty())
+                str_printf(&text[0], text.size() + 1, options.formatString, absValue);
+            return write_field(buffer, bufferSize, spec, &sign, sign ? 1 : 0, 0, text.data(), text.size(), true);
+        }
+
+        /// \brief Format double value according to format specification.
+        ///
+        /// Default type means shortest representation which is read back to the same value,
+        /// or \c g conversion if precision is specified. Precision larger than \ref max_exact_precision
+        /// is formatted by printf.
+        size_t format_double(char *buffer, size_t bufferSize, const format_spec &spec, double value, bool singlePrecision)
+        {
+            if (buffer != nullptr && bufferSize == 0)
+                return 0;
+
+            char sign = 0;
+            if (std::signbit(value))
+                sign = '-';
+            else if (spec.plus)
+                sign = '+';
+            else if (spec.space)
+                sign = ' ';
+
+            if (!std::isfinite(value))
+            {
+                const char *special = std::isnan(value)
+                    ? (spec.upper ? "NAN" : "nan")
+                    : (spec.upper ? "INF" : "inf");
+                return write_field(buffer, bufferSize, spec, &sign, sign ? 1 : 0, 0, special, 3, false);
+            }
+
+            double absValue = std::fabs(value);
+            if (spec.precision > max_exact_precision)
+                return printf_double(buffer, bufferSize, spec, sign, absValue);
+
+            char shortest[grisu_max_digits];
+            // exact digits are required only when shortest digits can't be rounded to precision
+            std::unique_ptr<char[]> exact;
+            decimal_digits d = { shortest, 0, 1 };
+            if (absValue != 0)
+            {
+                int exponent = 0;
+                d.count = singlePrecision
+                    ? grisu2(float(absValue), shortest, exponent)
+                    : grisu2(absValue, shortest, exponent);
+                d.point = d.count + exponent;
+                d.trim_zeros();
+            }
+
+            char type = has_type(spec, floating_point_types) ? char(spec.type | 0x20) : 0; // lower case
+            if (type == 0 && spec.precision >= 0)
+                type = 'g';
+            int precision = spec.precision >= 0 ? spec.precision : 6;
+            if (type == 'g' && precision == 0)
+                precision = 1;
+
+            if (type != 0)
+            {
+                int needed = type == 'f' ? d.point + precision
+                    : type == 'e' ? precision + 1
+                    : precision;
+                int exactDigits = singlePrecision
+                    ? (absValue < FLT_MIN ? 0 : exact_shortest_float_digits)
+                    : (absValue < DBL_MIN ? 0 : exact_shortest_digits);
+                bool rounded = (absValue == 0 || needed <= exactDigits) && d.round(needed);
+                if (!rounded)
+                {
+                    exact.reset(new char[max_exact_length]);
+                    d.digits = exact.get();
+                    exact_digits(absValue, type == 'f' ? 'f' : 'e', type == 'f' ? precision : needed - 1, d);
+                }
+            }
+
+            // only fixed notation of large value or large precision doesn't fit into stack buffer
+            char stackText[128];
+            std::unique_ptr<char[]> heapText;
+            char *text = stackText;
+            size_t textSize = (type == 'f' ? size_t(std::max(d.point, 1)) : 8) + size_t(precision) + 32;
+            if (textSize > sizeof(stackText))
+            {
+                heapText.reset(new char[textSize]);
+                text = heapText.get();
+            }
+            char *p = text;
+
+            int exponent = d.count > 0 ? d.point - 1 : 0;
+            char e = spec.upper ? 'E' : 'e';
+            switch (type)
+            {
+            case 'f':
+                p = write_fixed(p, d, precision, spec.alternate);
+                break;
+            case 'e':
+                p = write_scientific(p, d, precision, spec.alternate, e);
+                break;
+            case 'g':
+                if (exponent >= -4 && exponent < precision)
+                {
+                    int fraction = precision - 1 - exponent;
+                    if (!spec.alternate)
+                        fraction = std::min(fraction, std::max(0, d.count - d.point));
+                    p = write_fixed(p, d, fraction, spec.alternate);
+                }
+                else
+                {
+                    int fraction = precision - 1;
+                    if (!spec.alternate)
+                        fraction = std::min(fraction, std::max(0, d.count - 1));
+                    p = write_scientific(p, d, fraction, spec.alternate, e);
+                }
+                break;
+            default:
+                // shortest representation
+                if (exponent >= -4 && exponent < 16)
+                    p = write_fixed(p, d, std::max(0, d.count - d.point), spec.alternate);
+                else
+                    p = write_scientific(p, d, std::max(0, d.count - 1), spec.alternate, e);
+                break;
+            }
+
+            if (spec.localized)
+            {
+                std::string localized = localize_number(text, size_t(p - text), type != 'e');
+                return write_field(buffer, bufferSize, spec, &sign, sign ? 1 : 0, 0, localized.data(), localized.size(), true);
+            }
+            return write_field(buffer, bufferSize, spec, &sign, sign ? 1 : 0, 0, text, size_t(p - text), true);
+        }
+
+        /// printf conversion of single value, which supports measuring mode
+        template <class T>
+        size_t printf_format(char *buffer, size_t bufferSize, const char *format, T value)
+        {
+            if (buffer == nullptr)
+            {
+                ptrdiff_t length = str_printf_size(format, value);
+                return length > 0 ? size_t(length) : 0;
+            }
+            return str_printf(buffer, bufferSize, format, value);
+        }
+
+        /// \brief Format value natively if format string is understood by value formatter, otherwise use printf.
+        /// \param nativeTypes - conversion types supported by native formatting (default type is always supported)
+        template <class T>
+        size_t dispatch_format(char *buffer, size_t bufferSize, const format_options *format, void *value,
+                               size_t (*nativeFormat)(char *, size_t, const format_spec &, void *),
+                               const char *nativeTypes, T printfValue)
+        {
+            if (format == nullptr)
+                return nativeFormat(buffer, bufferSize, default_format_spec(), value);
+
+            const format_spec &spec = format->get_spec();
+            if (spec.native && (spec.type == 0 || strchr(nativeTypes, spec.type) != nullptr || format->formatString[0] == '\0'))
+                return nativeFormat(buffer, bufferSize, spec, value);
+            return printf_format(buffer, bufferSize, format->formatString, printfValue);
+        }
+    }
+}
+
+// batch formatting of numbers
+namespace strings
+{
+    namespace detail
+    {
+#if defined(STRINGS_FORMATTER_SSE2)
+        inline unsigned first_bit(uint32_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return unsigned(index);
+#else
+            return unsigned(__builtin_ctz(mask));
+#endif
+        }
+
+        /// \brief Convert value below 10^8 to 8 decimal digits (with leading zeros) in 16-bit lanes.
+        ///
+        /// Value is split to 4-digit halves, then each half is divided by 1000, 100, 10 and 1
+        /// with multiplications by reciprocals in all lanes at once.
+        inline __m128i convert_8_digits(uint32_t value)
+        {
+            // abcd, efgh = abcdefgh divmod 10000
+            const __m128i abcdefgh = _mm_cvtsi32_si128(int(value));
+            const __m128i abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, _mm_set1_epi32(int(0xd1b71759))), 45);
+            const __m128i efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, _mm_set1_epi32(10000)));
+
+            // [abcd * 4 (x4), efgh * 4 (x4)]
+            const __m128i v1 = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+            const __m128i v2 = _mm_unpacklo_epi32(_mm_unpacklo_epi16(v1, v1), _mm_unpacklo_epi16(v1, v1));
+
+            // [a, ab, abc, abcd, e, ef, efg, efgh]
+            const __m128i v3 = _mm_mulhi_epu16(v2, _mm_setr_epi16(8389, 5243, 13108, short(32768), 8389, 5243, 13108, short(32768)));
+            const __m128i v4 = _mm_mulhi_epu16(v3, _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, short(1 << 15), 1 << 7, 1 << 11, 1 << 13, short(1 << 15)));
+
+            // [a, b, c, d, e, f, g, h] = v4 - [0, a0, ab0, abc0, 0, e0, ef0, efg0]
+            const __m128i v5 = _mm_mullo_epi16(v4, _mm_set1_epi16(10));
+            return _mm_sub_epi16(v4, _mm_slli_epi64(v5, 16));
+        }
+#endif
+
+        /// Write decimal digits of value forward, return pointer past last digit (at least 20 characters are available)
+        inline char *write_decimal(char *p, uint64_t value)
+        {
+#if defined(STRINGS_FORMATTER_SSE2)
+            if (value >= 100000000)
+            {
+                const uint64_t e16 = 10000000000000000ull;
+                bool leading = value >= e16;
+                if (leading)
+                {
+                    // up to 4 leading digits, the rest is exactly 16 digits
+                    char top[8];
+                    char *first = format_decimal(top + sizeof(top), value / e16);
+                    size_t count = size_t(top + sizeof(top) - first);
+                    memcpy(p, first, count);
+                    p += count;
+                    value %= e16;
+                }
+
+                __m128i digits = _mm_add_epi8(
+                    _mm_packus_epi16(convert_8_digits(uint32_t(value / 100000000)), convert_8_digits(uint32_t(value % 100000000))),
+                    _mm_set1_epi8('0'));
+                char text[16];
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(text), digits);
+                // leading zeros are skipped unless there are leading digits already
+                uint32_t zeros = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(digits, _mm_set1_epi8('0'))));
+                unsigned skip = leading ? 0 : first_bit(~zeros);
+                memcpy(p, text + skip, 16 - skip);
+                return p + 16 - skip;
+            }
+#endif
+            char digits[24];
+            char *first = format_decimal(digits + sizeof(digits), value);
+            size_t count = size_t(digits + sizeof(digits) - first);
+            memcpy(p, first, count);
+            return p + count;
+        }
+
+        template <class T> inline bool is_negative(T value, std::true_type) { return value < 0; }
+        template <class T> inline bool is_negative(T, std::false_type) { return false; }
+
+        /// Integer array elements: default decimal conversion is written without format_integer
+        template <class T>
+        struct array_element
+        {
+            bool fast;
+            char type;
+            size_t limit;
+
+            explicit array_element(const format_spec &spec)
+                : fast(spec.width == 0 && spec.precision < 0 && spec.bits == 0 && !spec.plus && !spec.space && !spec.localized
+                       && (spec.type == 0 || has_type(spec, "diu")))
+                , type(has_type(spec, integer_types) ? spec.type : std::is_signed<T>::value ? 'd' : 'u')
+                , limit(std::max(spec.width, size_t(std::max(spec.precision, 0))) + 24)
+            {}
+
+            char *write(char *p, size_t size, T value, const format_spec &spec) const
+            {
+                if (!fast)
+                    return p + format_integer(p, size, spec, type, std::is_signed<T>::value ? uint64_t(int64_t(value)) : uint64_t(value));
+                if (is_negative(value, std::is_signed<T>()))
+                {
+                    *p++ = '-';
+                    return write_decimal(p, 0 - uint64_t(int64_t(value)));
+                }
+                return write_decimal(p, uint64_t(value));
+            }
+        };
+
+        template <class T>
+        struct float_array_element
+        {
+            size_t limit;
+
+            explicit float_array_element(const format_spec &spec)
+                : limit(spec.width + digits_limit(spec) + 16)
+            {}
+
+            /// \brief Upper bound of digits, separators and exponent written for any value
+            static size_t digits_limit(const format_spec &spec)
+            {
+                bool fixed = spec.type == 'f' || spec.type == 'F';
+                // fixed notation writes up to 309 integer digits, default precision is 6,
+                // shortest representation takes up to 17 significant digits
+                size_t digits = (fixed ? 310 : 32) + (spec.precision >= 0 ? size_t(spec.precision) : 17);
+                // digit group separators from locale take up to 3 bytes per 3 digits
+                return spec.localized ? 2 * digits : digits;
+            }
+
+            char *write(char *p, size_t size, T value, const format_spec &spec) const
+            {
+                return p + format_double(p, size, spec, value, sizeof(T) == sizeof(float));
+            }
+        };
+
+        template <> struct array_element<float> : float_array_element<float> { explicit array_element(const format_spec &spec) : float_array_element<float>(spec) {} };
+        template <> struct array_element<double> : float_array_element<double> { explicit array_element(const format_spec &spec) : float_array_element<double>(spec) {} };
+
+        template <class T>
+        size_t format_array(char *buffer, size_t bufferSize, const T *values, size_t count,
+                            const char *delimiter, size_t delimiterSize, bool leadingDelimiter,
+                            const format_spec &spec, size_t &length)
+        {
+            const array_element<T> element(spec);
+            char *p = buffer;
+            char *end = buffer + bufferSize - 1;
+            size_t i = 0;
+            for (; i < count; ++i)
+            {
+                bool delimited = leadingDelimiter || i != 0;
+                size_t needed = element.limit + (delimited ? delimiterSize : 0);
+                if (size_t(end - p) < needed)
+                {
+                    if (i == 0)
+                    {
+                        // single element doesn't fit: report buffer size needed for it
+                        length = needed + 1;
+                        return 0;
+                    }
+                    break;
+                }
+                if (delimited)
+                {
+                    memcpy(p, delimiter, delimiterSize);
+                    p += delimiterSize;
+                }
+                p = element.write(p, size_t(end - p) + 1, values[i], spec);
+            }
+            length = size_t(p - buffer);
+            return i;
+        }
+
+#define STRINGS_INSTANTIATE_FORMAT_ARRAY(T) \
+        template size_t format_array<T>(char *, size_t, const T *, size_t, const char *, size_t, bool, const format_spec &, size_t &);
+
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(signed char)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(short)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(int)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(long)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(long long)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(unsigned char)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(unsigned short)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(unsigned int)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(unsigned long)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(unsigned long long)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(float)
+        STRINGS_INSTANTIATE_FORMAT_ARRAY(double)
+
+#undef STRINGS_INSTANTIATE_FORMAT_ARRAY
+    }
+}
+
+// timestamp conversion
+namespace strings
+{
+    namespace detail
+    {
+        /// Date and time up to seconds and zone designator, rendered for single second
+        struct timestamp_cache
+        {
+            int64_t second;
+            size_t length;
+            char text[32];
+            size_t zoneLength;
+            char zone[8];
+        };
+
+        inline int64_t floor_div(int64_t value, int64_t divisor)
+        {
+            int64_t result = value / divisor;
+            return (value % divisor < 0) ? result - 1 : result;
+        }
+
+        /// \brief Civil date (proleptic Gregorian calendar) of day since 1970-01-01.
+        ///
+        /// Algorithm by Howard Hinnant (http://howardhinnant.github.io/date_algorithms.html).
+        void civil_from_days(int64_t days, int64_t &year, unsigned &month, unsigned &day)
+        {
+            days += 719468;
+            int64_t era = floor_div(days, 146097);
+            unsigned dayOfEra = unsigned(days - era * 146097);
+            unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+            day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+            month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+            year = int64_t(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+        }
+
+        /// Day since 1970-01-01 of civil date, inverse of civil_from_days
+        int64_t days_from_civil(int64_t year, unsigned month, unsigned day)
+        {
+            year -= month <= 2 ? 1 : 0;
+            int64_t era = floor_div(year, 400);
+            unsigned yearOfEra = unsigned(year - era * 400);
+            unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097 + int64_t(dayOfEra) - 719468;
+        }
+
+        inline char *write_two_digits(char *p, unsigned value)
+        {
+            memcpy(p, digit_pairs + value * 2, 2);
+            return p + 2;
+        }
+
+        /// \brief Render \c YYYY-MM-DDTHH:MM:SS and zone designator of second since Unix epoch.
+        /// Zone designator is \c Z for UTC, otherwise offset from UTC.
+        void render_timestamp(int64_t second, timestamp::zone_type zone, timestamp_cache &cache)
+        {
+            int64_t zoneSecond = second;
+            if (zone == timestamp::local)
+            {
+                time_t time = time_t(second);
+                tm parts = {};
+#if defined(_WIN32)
+                localtime_s(&parts, &time);
+#else
+                localtime_r(&time, &parts);
+#endif
+                zoneSecond = days_from_civil(parts.tm_year + 1900, unsigned(parts.tm_mon + 1), unsigned(parts.tm_mday)) * 86400
+                    + parts.tm_hour * 3600 + parts.tm_min * 60 + parts.tm_sec;
+            }
+
+            int64_t days = floor_div(zoneSecond, 86400);
+            unsigned secondOfDay = unsigned(zoneSecond - days * 86400);
+            int64_t year;
+            unsigned month, day;
+            civil_from_days(days, year, month, day);
+
+            char *p = cache.text;
+            if (year >= 0 && year <= 9999)
+            {
+                p = write_two_digits(p, unsigned(year / 100));
+                p = write_two_digits(p, unsigned(year % 100));
+            }
+            else
+            {
+                // expanded representation is out of scope, keep sign and all digits
+                char digits[24];
+                char *digitsEnd = digits + sizeof(digits);
+                char *first = format_decimal(digitsEnd, uint64_t(year < 0 ? -year : year));
+                *p++ = year < 0 ? '-' : '+';
+                memcpy(p, first, size_t(digitsEnd - first));
+                p += digitsEnd - first;
+            }
+            *p++ = '-';
+            p = write_two_digits(p, month);
+            *p++ = '-';
+            p = write_two_digits(p, day);
+            *p++ = 'T';
+            p = write_two_digits(p, secondOfDay / 3600);
+            *p++ = ':';
+            p = write_two_digits(p, secondOfDay / 60 % 60);
+            *p++ = ':';
+            p = write_two_digits(p, secondOfDay % 60);
+            cache.length = size_t(p - cache.text);
+
+            p = cache.zone;
+            if (zone == timestamp::utc)
+            {
+                *p++ = 'Z';
+            }
+            else
+            {
+                int64_t offset = (zoneSecond - second) / 60;
+                *p++ = offset < 0 ? '-' : '+';
+                unsigned absOffset = unsigned(offset < 0 ? -offset : offset);
+                p = write_two_digits(p, absOffset / 60 % 100);
+                *p++ = ':';
+                p = write_two_digits(p, absOffset % 60);
+            }
+            cache.zoneLength = size_t(p - cache.zone);
+            cache.second = second;
+        }
+
+        const uint32_t fraction_divisors[] = { 1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1 };
+    }
+}
+
+namespace strings
+{
+    namespace detail
+    {
+        const formatter_vtable function_value::vtable = { &function_value::format_value, &function_value::format_with_spec, nullptr, &function_value::destroy };
+    }
+
+    format_options make_format_options(const format_spec &spec)
+    {
+        format_options options = {};
+        options.width = spec.width;
+        options.alignment = spec.alignment;
+        options.fill = spec.fill;
+        if (spec.type == 0)
+        {
+            if (spec.precision == 0)
+                options.precision = format_options::zero_precision;
+            else if (spec.precision > 0)
+                options.precision = size_t(spec.precision);
+            return options;
+        }
+
+        char *p = options.formatString;
+        *p++ = '%';
+        if (spec.plus) *p++ = '+';
+        if (spec.space) *p++ = ' ';
+        if (spec.alternate) *p++ = '#';
+        if (spec.zero) *p++ = '0';
+        if (spec.localized) *p++ = '\'';
+        if (spec.precision >= 0)
+        {
+            char digits[16];
+            char *end = digits + sizeof(digits);
+            char *first = detail::format_decimal(end, uint64_t(spec.precision));
+            *p++ = '.';
+            memcpy(p, first, size_t(end - first));
+            p += end - first;
+        }
+        switch (spec.bits)
+        {
+        case 8: *p++ = 'h'; *p++ = 'h'; break;
+        case 16: *p++ = 'h'; break;
+        case 64: *p++ = 'l'; *p++ = 'l'; break;
+        case 0:
+            // whole value: without length modifier printf conversion would truncate it to int
+            if (detail::has_type(spec, detail::integer_types))
+            {
+                *p++ = 'l';
+                *p++ = 'l';
+            }
+            break;
+        }
+        *p++ = spec.type;
+        *p = '\0';
+        return options;
+    }
+
+    size_t bool_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        bool v = (bool)reinterpret_cast<size_t>(value);
+        if (detail::has_type(spec, detail::integer_types))
+            return detail::format_integer(buffer, bufferSize, spec, spec.type, v ? 1 : 0);
+
+        static const char* bool_values[] = {"false", "true"};
+        const char *bool_str = bool_values[v ? 1 : 0];
+        size_t length = v ? 4 : 5;
+        if (spec.precision >= 0)
+            length = std::min(length, size_t(spec.precision));
+        return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, bool_str, length, false);
+    }
+
+    size_t bool_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    {
+        bool v = (bool)reinterpret_cast<size_t>(value);
+        return detail::dispatch_format(buffer, bufferSize, format, value, &bool_format, "sdiuoxX", v);
+    }
+
+    size_t char_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        char v = (char)reinterpret_cast<ptrdiff_t>(value);
+        if (detail::has_type(spec, detail::integer_types))
+            return detail::format_integer(buffer, bufferSize, spec, spec.type, uint64_t(int64_t(v)));
+        return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, &v, 1, false);
+    }
+
+    size_t char_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    {
+        char v = (char)reinterpret_cast<ptrdiff_t>(value);
+        return detail::dispatch_format(buffer, bufferSize, format, value, &char_format, "cdiuoxX", v);
+    }
+
+    size_t wchar_t_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        wchar_t v = (wchar_t)reinterpret_cast<ptrdiff_t>(value);
+        if (detail::has_type(spec, detail::integer_types))
+            return detail::format_integer(buffer, bufferSize, spec, spec.type, uint64_t(int64_t(v)));
+
+        char narrowed[8];
+        boost::nowide::narrow(narrowed, sizeof(narrowed), &v, &v + 1);
+        return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, narrowed, strlen(narrowed), false);
     }
 
     size_t wchar_t_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
     {
         wchar_t v = (wchar_t)reinterpret_cast<ptrdiff_t>(value);
-        if (format == nullptr)
+        return detail::dispatch_format(buffer, bufferSize, format, value, &wchar_t_format, "diuoxX", v);
+    }
+
+    size_t char_str_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        const char *v = reinterpret_cast<const char *>(value);
+        if (spec.width == 0 && spec.precision < 0)
         {
-            boost::nowide::narrow(buffer, bufferSize, &v, &v + 1);
-            return strlen(buffer);
+            if (buffer == nullptr)
+                return v != nullptr ? strlen(v) : 0;
+            return string_copy(buffer, bufferSize, v);
         }
-        return str_printf(buffer, bufferSize, format->formatString, v);
+
+        size_t length = 0;
+        if (v != nullptr)
+        {
+            const char *end = spec.precision >= 0
+                ? static_cast<const char *>(memchr(v, 0, size_t(spec.precision)))
+                : nullptr;
+            length = spec.precision >= 0
+                ? (end ? size_t(end - v) : size_t(spec.precision))
+                : strlen(v);
+        }
+        return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, v, length, false);
     }
 
     size_t char_str_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
     {
         const char *v = reinterpret_cast<const char *>(value);
+        return detail::dispatch_format(buffer, bufferSize, format, value, &char_str_format, "s", v);
+    }
+
+    /// \brief Format string with known length.
+    ///
+    /// Characters are copied in single pass and may contain zeros,
+    /// precision limits count of copied characters.
+    size_t char_str_format(char *buffer, size_t bufferSize, const format_spec &spec, const char *value, size_t length)
+    {
+        if (spec.precision >= 0)
+            length = std::min(length, size_t(spec.precision));
+        if (spec.width != 0)
+            return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, value, length, false);
+
+        if (buffer == nullptr)
+            return length;
+        if (bufferSize == 0)
+            return 0;
+        length = std::min(length, bufferSize - 1);
+        memcpy(buffer, value, length);
+        buffer[length] = '\0';
+        return length;
+    }
+
+    /// \copydoc char_str_format(char*, size_t, const format_spec &, const char*, size_t)
+    size_t char_str_format(char *buffer, size_t bufferSize, const format_options *format, const char *value, size_t length)
+    {
         if (format == nullptr)
-        {
-            return string_copy(buffer, bufferSize, v);
-        }
-        return str_printf(buffer, bufferSize, format->formatString, v);
+            return char_str_format(buffer, bufferSize, default_format_spec(), value, length);
+
+        const format_spec &spec = format->get_spec();
+        if (spec.native && (spec.type == 0 || spec.type == 's' || format->formatString[0] == '\0'))
+            return char_str_format(buffer, bufferSize, spec, value, length);
+
+        // printf needs null-terminated string
+        std::string text(value, length);
+        return detail::printf_format(buffer, bufferSize, format->formatString, text.c_str());
+    }
+
+    size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        const wchar_t *v = reinterpret_cast<const wchar_t *>(value);
+        return wchar_t_str_format(buffer, bufferSize, spec, v, v != nullptr ? wcslen(v) : 0);
     }
 
     size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
     {
         const wchar_t *v = reinterpret_cast<const wchar_t *>(value);
+        return wchar_t_str_format(buffer, bufferSize, format, v, v != nullptr ? wcslen(v) : 0);
+    }
+
+    /// \brief Format wide string with known length.
+    ///
+    /// Characters are converted to UTF-8 in single pass,
+    /// precision limits count of bytes in converted string.
+    size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_spec &spec, const wchar_t *value, size_t length)
+    {
+        size_t limit = spec.precision >= 0 ? size_t(spec.precision) + 1 : SIZE_MAX;
+        if (buffer == nullptr)
+            return detail::pad_in_place(nullptr, 0, detail::narrow(nullptr, limit, value, value + length), spec);
+        if (bufferSize == 0)
+            return 0;
+
+        size_t narrowed = detail::narrow(buffer, std::min(bufferSize, limit), value, value + length);
+        return detail::pad_in_place(buffer, bufferSize, narrowed, spec);
+    }
+
+    /// \copydoc wchar_t_str_format(char*, size_t, const format_spec &, const wchar_t*, size_t)
+    size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_options *format, const wchar_t *value, size_t length)
+    {
         if (format == nullptr)
-        {
-            boost::nowide::narrow(buffer, bufferSize, v);
-            return strlen(buffer);
-        }
-        return str_printf(buffer, bufferSize, format->formatString, v);
+            return wchar_t_str_format(buffer, bufferSize, default_format_spec(), value, length);
+
+        const format_spec &spec = format->get_spec();
+        if (spec.native && (spec.type == 0 || spec.type == 's' || format->formatString[0] == '\0'))
+            return wchar_t_str_format(buffer, bufferSize, spec, value, length);
+
+        // printf doesn't convert wide strings to UTF-8
+        std::string text(detail::narrow(nullptr, SIZE_MAX, value, value + length), '\0');
+        detail::narrow(&text[0], text.size() + 1, value, value + length);
+        return detail::printf_format(buffer, bufferSize, format->formatString, text.c_str());
     }
 
-    size_t signed_integer_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    size_t signed_integer_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
     {
-        static format_options defaultIntFormatOptions = { "%d", 0, 0 };
-        if (format == nullptr) format = &defaultIntFormatOptions;
+        ptrdiff_t v = reinterpret_cast<ptrdiff_t>(value);
+        char type = detail::has_type(spec, detail::integer_types) ? spec.type : 'd';
+        return detail::format_integer(buffer, bufferSize, spec, type, uint64_t(int64_t(v)));
+    }
 
+    size_t signed_integer_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    {
         ptrdiff_t v = reinterpret_cast<ptrdiff_t>(value);
-        return str_printf(buffer, bufferSize, format->formatString, v);
+        return detail::dispatch_format(buffer, bufferSize, format, value, &signed_integer_format, detail::integer_types, v);
     }
 
-    size_t unsigned_integer_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    size_t unsigned_integer_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
     {
-        static format_options defaultIntFormatOptions = { "%d", 0, 0 };
-        if (format == nullptr) format = &defaultIntFormatOptions;
+        size_t v = reinterpret_cast<size_t>(value);
+        char type = detail::has_type(spec, detail::integer_types) ? spec.type : 'u';
+        return detail::format_integer(buffer, bufferSize, spec, type, uint64_t(v));
+    }
 
+    size_t unsigned_integer_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    {
         size_t v = reinterpret_cast<size_t>(value);
-        return str_printf(buffer, bufferSize, format->formatString, v);
+        return detail::dispatch_format(buffer, bufferSize, format, value, &unsigned_integer_format, detail::integer_types, v);
+    }
+
+    /// \brief Format floating point value.
+    ///
+    /// By default value is formatted in shortest form which is read back
+    /// to the same value. Format string may contain single printf conversion
+    /// (\c f, \c e, \c g with flags, width and precision), empty format string
+    /// with non-zero \c precision is the same as \c "%.<precision>g".
+    size_t double_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        double v = detail::double_storage<>::load(value);
+        return detail::format_double(buffer, bufferSize, spec, v, false);
+    }
+
+    /// \copydoc double_format(char*, size_t, const format_spec &, void*)
+    size_t double_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    {
+        double v = detail::double_storage<>::load(value);
+        return detail::dispatch_format(buffer, bufferSize, format, value, &double_format, detail::floating_point_types, v);
+    }
+
+    /// \copydoc double_format(char*, size_t, const format_spec &, void*)
+    size_t float_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        float v;
+        memcpy(&v, &value, sizeof(v));
+        return detail::format_double(buffer, bufferSize, spec, v, true);
+    }
+
+    /// \copydoc double_format(char*, size_t, const format_spec &, void*)
+    size_t float_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
+    {
+        float v;
+        memcpy(&v, &value, sizeof(v));
+        return detail::dispatch_format(buffer, bufferSize, format, value, &float_format, detail::floating_point_types, double(v));
+    }
+
+    size_t pointer_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value)
+    {
+        // pointer is always formatted whole, length modifier (or int width of printf conversion) doesn't apply
+        format_spec pointerSpec = spec;
+        pointerSpec.bits = 0;
+        if (detail::has_type(spec, "xX"))
+            return detail::format_integer(buffer, bufferSize, pointerSpec, spec.type, uint64_t(reinterpret_cast<uintptr_t>(value)));
+
+        // the same output as printf("%p") of platform C library
+        pointerSpec.precision = -1;
+#if defined(_MSC_VER)
+        pointerSpec.type = 'X';
+        pointerSpec.precision = int(sizeof(void *) * 2);
+#else
+        if (value == nullptr)
+            return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, "(nil)", 5, false);
+        pointerSpec.type = 'x';
+        pointerSpec.alternate = true;
+#endif
+        return detail::format_integer(buffer, bufferSize, pointerSpec, pointerSpec.type, uint64_t(reinterpret_cast<uintptr_t>(value)));
     }
 
     size_t pointer_format(char *buffer, size_t bufferSize, const format_options *format, void *value)
     {
-        if (format == nullptr)
+        return detail::dispatch_format(buffer, bufferSize, format, value, &pointer_format, "pxX", value);
+    }
+
+    timestamp timestamp::now(precision_type precision, zone_type zone)
+    {
+        return from_time_point(std::chrono::system_clock::now(), precision, zone);
+    }
+
+    timestamp timestamp::from_time_point(std::chrono::system_clock::time_point time, precision_type precision, zone_type zone)
+    {
+        timestamp result = {
+            int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()),
+            precision,
+            zone
+        };
+        return result;
+    }
+
+    size_t timestamp_format(char *buffer, size_t bufferSize, const format_spec &spec, const timestamp &value)
+    {
+        static PLATFORM_THREAD_LOCAL detail::timestamp_cache caches[2] = { { INT64_MIN, 0, {}, 0, {} }, { INT64_MIN, 0, {}, 0, {} } };
+
+        int64_t second = detail::floor_div(value.time, 1000000000);
+        uint32_t fraction = uint32_t(value.time - second * 1000000000);
+        detail::timestamp_cache &cache = caches[value.zone == timestamp::local ? 1 : 0];
+        if (cache.second != second)
+            detail::render_timestamp(second, value.zone, cache);
+
+        char text[64];
+        memcpy(text, cache.text, cache.length);
+        char *p = text + cache.length;
+
+        int precision = spec.precision >= 0 ? std::min(spec.precision, 9) : int(value.precision);
+        if (precision > 0)
         {
-            return str_printf(buffer, bufferSize, "%p", value);
+            *p++ = '.';
+            uint32_t digits = fraction / detail::fraction_divisors[precision];
+            for (int i = precision - 1; i >= 0; --i)
+            {
+                p[i] = char('0' + digits % 10);
+                digits /= 10;
+            }
+            p += precision;
         }
-        return str_printf(buffer, bufferSize, format->formatString, value);
+        memcpy(p, cache.zone, cache.zoneLength);
+        p += cache.zoneLength;
+        return detail::write_field(buffer, bufferSize, spec, nullptr, 0, 0, text, size_t(p - text), false);
     }
 
+    size_t timestamp_format(char *buffer, size_t bufferSize, const format_options *format, const timestamp &value)
+    {
+        return timestamp_format(buffer, bufferSize, format != nullptr ? format->get_spec() : default_format_spec(), value);
+    }
 }
@@ -1,19 +1,108 @@
 #ifndef __FORMATTER_HEADER_H__
 #define __FORMATTER_HEADER_H__
 
+#include "string_view.h"
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <new>
 #include <string>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#include <type_traits>
+#include <utility>
 
 namespace strings
 {
+    /// \brief Compiled format specification.
+    ///
+    /// Specification is parsed once from printf-like format string
+    /// (see \ref parse_format_spec()) and then can be used to format
+    /// many values without parsing format string again.
+    ///
+    /// Native formatting doesn't depend on C locale: decimal point is always '.'
+    /// and digits are never grouped, so output doesn't change after \c setlocale()
+    /// and formatting threads don't touch locale data. Flag \c ' (like in POSIX printf)
+    /// opts in to decimal point and digit grouping of current C locale.
+    struct format_spec
+    {
+        enum alignment_type { align_default, align_left, align_right, align_center };
+
+        char type;                  ///< conversion: d, i, u, o, x, X, c, s, p, f, F, e, E, g, G or 0 (default for value type)
+        alignment_type alignment;   ///< alignment within field width (default is right alignment)
+        char fill;                  ///< character used to pad value to field width
+        bool plus;                  ///< always print sign of signed number
+        bool space;                 ///< print space instead of plus sign
+        bool alternate;             ///< 0x prefix for hex, leading zero for octal, always print decimal point
+        bool zero;                  ///< pad number with zeros after sign
+        bool upper;                 ///< upper case for hex digits, exponent, inf and nan
+        unsigned base;              ///< integer base: 8, 10 or 16
+        unsigned bits;              ///< integer argument size in bits from length modifier (0 - whole value)
+        size_t width;               ///< minimal field width
+        int precision;              ///< precision (-1 if not specified)
+        bool native;                ///< false if format string can be processed with printf only
+        bool localized;             ///< use decimal point and digit grouping of current C locale
+    };
+
+    bool parse_format_spec(const char *formatString, format_spec &spec);
+    bool parse_format_spec(const char *begin, const char *end, format_spec &spec);
+    const format_spec &default_format_spec();
+
+    /// \brief Format options with printf-like format string.
+    ///
+    /// Format string is parsed on every use, so options may be changed between uses.
+    /// To format many values with the same format string, compile it once with
+    /// \ref parse_format_spec() and pass \ref format_spec to formatter instead.
+    /// \c width and \c precision are used when format string doesn't specify them,
+    /// \c alignment and \c fill (if not zero) override alignment and padding character,
+    /// so values can be aligned in columns without printf format strings:
+    ///
+    /// ~~~{.c}
+    /// strings::format_options column{"", 12, 0, strings::format_spec::align_center, '.'};
+    /// strings::get_formatter("name").format(buffer, bufferSize, &column); // "....name...."
+    /// ~~~
     struct format_options
     {
         char formatString[32];
         size_t width;
         size_t precision;
+        format_spec::alignment_type alignment;
+        char fill;
+
+        /// Value of \ref precision for explicit zero precision (0 means precision isn't specified)
+        static const size_t zero_precision = size_t(-1);
+
+        /// Parse format string and apply width, precision, alignment and fill to it
+        format_spec get_spec() const
+        {
+            format_spec spec;
+            parse_format_spec(formatString, spec);
+            if (spec.width == 0)
+                spec.width = width;
+            if (spec.precision < 0 && precision == zero_precision)
+                spec.precision = 0;
+            else if (spec.precision < 0 && precision != 0)
+                spec.precision = int(precision);
+            if (alignment != format_spec::align_default)
+                spec.alignment = alignment;
+            if (fill != 0)
+                spec.fill = fill;
+            return spec;
+        }
     };
 
+    /// \brief Make format options from compiled format specification.
+    ///
+    /// Used to pass specification to format functions, which accept only format options.
+    /// Conversion is written to format string, width, alignment and fill are stored in fields.
+    format_options make_format_options(const format_spec &spec);
+
+    /// Value format functions write formatted value and terminating zero to buffer
+    /// and return count of written characters (output is truncated to bufferSize - 1).
+    /// If buffer is nullptr, nothing is written and function returns length
+    /// of whole formatted value (measuring mode).
     size_t bool_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
     size_t char_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
     size_t wchar_t_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
@@ -21,52 +110,454 @@ namespace strings
     size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
     size_t signed_integer_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
     size_t unsigned_integer_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
+    size_t double_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
+    size_t float_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
     size_t pointer_format(char *buffer, size_t bufferSize, const format_options *format, void *value);
 
+    size_t bool_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t char_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t wchar_t_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t char_str_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t signed_integer_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t unsigned_integer_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t double_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t float_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+    size_t pointer_format(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+
+    /// \brief Point in time, formatted as ISO-8601 date and time, e.g. \c 2024-05-01T12:34:56.789Z.
+    ///
+    /// Date and time up to seconds are rendered once per second and cached per thread,
+    /// so usually only fractional digits are formatted. Local time is written with
+    /// offset from UTC (\c +03:00). Precision of format specification overrides
+    /// precision of timestamp.
+    struct timestamp
+    {
+        enum precision_type { seconds = 0, milliseconds = 3, microseconds = 6, nanoseconds = 9 };
+        enum zone_type { utc, local };
+
+        /// Nanoseconds since Unix epoch
+        int64_t time;
+        precision_type precision;
+        zone_type zone;
+
+        static timestamp now(precision_type precision = milliseconds, zone_type zone = utc);
+        static timestamp from_time_point(std::chrono::system_clock::time_point time,
+                                         precision_type precision = milliseconds, zone_type zone = utc);
+    };
+
+    size_t timestamp_format(char *buffer, size_t bufferSize, const format_options *format, const timestamp &value);
+    size_t timestamp_format(char *buffer, size_t bufferSize, const format_spec &spec, const timestamp &value);
+
+    size_t char_str_format(char *buffer, size_t bufferSize, const format_options *format, const char *value, size_t length);
+    size_t char_str_format(char *buffer, size_t bufferSize, const format_spec &spec, const char *value, size_t length);
+    size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_options *format, const wchar_t *value, size_t length);
+    size_t wchar_t_str_format(char *buffer, size_t bufferSize, const format_spec &spec, const wchar_t *value, size_t length);
+
+    class formatter;
+
+    namespace detail
+    {
+        typedef size_t (*format_value_function)(char *buffer, size_t bufferSize, const format_options *format, void *value);
+        typedef size_t (*format_spec_function)(char *buffer, size_t bufferSize, const format_spec &spec, void *value);
+
+        /// Operations on value stored in formatter
+        struct formatter_vtable
+        {
+            size_t (*format)(char *buffer, size_t bufferSize, const format_options *format, const void *storage);
+            /// Format value with compiled specification
+            size_t (*format_with_spec)(char *buffer, size_t bufferSize, const format_spec &spec, const void *storage);
+            /// Move value from source storage to destination and destroy source, nullptr for trivially copyable values
+            void (*move)(void *destination, void *source);
+            /// Destroy value, nullptr for trivially destructible values
+            void (*destroy)(void *storage);
+        };
+
+        /// Size of value which is stored inside of formatter without heap allocation
+        const size_t formatter_inline_size = 24;
+
+        union formatter_storage
+        {
+            void *pointer;
+            double number;
+            uint64_t integer;
+            char bytes[formatter_inline_size];
+        };
+
+        template <class T>
+        struct fits_formatter_storage
+        {
+            static const bool value = sizeof(T) <= sizeof(formatter_storage)
+                && std::alignment_of<formatter_storage>::value % std::alignment_of<T>::value == 0;
+        };
+
+        /// Value of built-in type, packed into void* and formatted by Format or FormatSpec function
+        template <format_value_function Format, format_spec_function FormatSpec>
+        struct pointer_value
+        {
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const void *storage)
+            {
+                return Format(buffer, bufferSize, format, *static_cast<void * const *>(storage));
+            }
+
+            static size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const void *storage)
+            {
+                return FormatSpec(buffer, bufferSize, spec, *static_cast<void * const *>(storage));
+            }
+
+            static const formatter_vtable vtable;
+        };
+
+        template <format_value_function Format, format_spec_function FormatSpec>
+        const formatter_vtable pointer_value<Format, FormatSpec>::vtable = { &pointer_value::format, &pointer_value::format_with_spec, nullptr, nullptr };
+
+        /// Value, formatted by function with optional cleanup (see formatter(void*, format_value, clean_value))
+        struct function_value
+        {
+            void *value;
+            format_value_function format;
+            void (*clean)(void *value);
+
+            static size_t format_value(char *buffer, size_t bufferSize, const format_options *format, const void *storage)
+            {
+                const function_value *v = static_cast<const function_value *>(storage);
+                return v->format != nullptr ? v->format(buffer, bufferSize, format, v->value) : 0;
+            }
+
+            static size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const void *storage)
+            {
+                format_options options = make_format_options(spec);
+                return format_value(buffer, bufferSize, &options, storage);
+            }
+
+            static void destroy(void *storage)
+            {
+                function_value *v = static_cast<function_value *>(storage);
+                if (v->clean && v->value)
+                    v->clean(v->value);
+            }
+
+            static const formatter_vtable vtable;
+        };
+
+        template <class Traits, class T>
+        struct has_spec_format
+        {
+            template <class U> static char test(decltype(U::format(nullptr, size_t(0), std::declval<const format_spec &>(), std::declval<const T &>())) *);
+            template <class U> static long test(...);
+            static const bool value = sizeof(test<Traits>(nullptr)) == sizeof(char);
+        };
+
+        template <class Traits, class T>
+        size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const T &value, std::true_type)
+        {
+            return Traits::format(buffer, bufferSize, spec, value);
+        }
+
+        template <class Traits, class T>
+        size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const T &value, std::false_type)
+        {
+            format_options options = make_format_options(spec);
+            return Traits::format(buffer, bufferSize, &options, value);
+        }
+
+        /// \brief Format value with compiled specification by Traits.
+        ///
+        /// Traits, which format values with format options only, get options made from specification.
+        template <class Traits, class T>
+        size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const T &value)
+        {
+            return format_with_spec<Traits>(buffer, bufferSize, spec, value, std::integral_constant<bool, has_spec_format<Traits, T>::value>());
+        }
+
+        /// Value of type T stored inside of formatter and formatted by Traits::format
+        template <class T, class Traits>
+        struct inline_value
+        {
+            template <class U>
+            static void construct(void *storage, U &&value)
+            {
+                new (storage) T(std::forward<U>(value));
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const void *storage)
+            {
+                return Traits::format(buffer, bufferSize, format, *static_cast<const T *>(storage));
+            }
+
+            static size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const void *storage)
+            {
+                return detail::format_with_spec<Traits>(buffer, bufferSize, spec, *static_cast<const T *>(storage));
+            }
+
+            static void move(void *destination, void *source)
+            {
+                T *value = static_cast<T *>(source);
+                new (destination) T(std::move(*value));
+                value->~T();
+            }
+
+            static void destroy(void *storage)
+            {
+                static_cast<T *>(storage)->~T();
+            }
+
+            static const formatter_vtable vtable;
+        };
+
+        template <class T, class Traits>
+        const formatter_vtable inline_value<T, Traits>::vtable = {
+            &inline_value::format,
+            &inline_value::format_with_spec,
+            std::is_pod<T>::value ? nullptr : &inline_value::move,
+            std::is_pod<T>::value ? nullptr : &inline_value::destroy
+        };
+
+        /// Value of type T, which doesn't fit into formatter, stored on heap
+        template <class T, class Traits>
+        struct heap_value
+        {
+            template <class U>
+            static void construct(void *storage, U &&value)
+            {
+                *static_cast<T **>(storage) = new T(std::forward<U>(value));
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const void *storage)
+            {
+                return Traits::format(buffer, bufferSize, format, **static_cast<T * const *>(storage));
+            }
+
+            static size_t format_with_spec(char *buffer, size_t bufferSize, const format_spec &spec, const void *storage)
+            {
+                return detail::format_with_spec<Traits>(buffer, bufferSize, spec, **static_cast<T * const *>(storage));
+            }
+
+            static void destroy(void *storage)
+            {
+                delete *static_cast<T **>(storage);
+            }
+
+            static const formatter_vtable vtable;
+        };
+
+        template <class T, class Traits>
+        const formatter_vtable heap_value<T, Traits>::vtable = { &heap_value::format, &heap_value::format_with_spec, nullptr, &heap_value::destroy };
+
+        /// double_format expects bits of double in void* if they fit, otherwise pointer to double
+        template <bool fits_pointer = sizeof(double) <= sizeof(void*)>
+        struct double_storage
+        {
+            static void *argument(const double &value)
+            {
+                void *result = nullptr;
+                memcpy(&result, &value, sizeof(value));
+                return result;
+            }
+
+            static double load(void *value)
+            {
+                double result;
+                memcpy(&result, &value, sizeof(result));
+                return result;
+            }
+        };
+
+        template <>
+        struct double_storage<false>
+        {
+            static void *argument(const double &value) { return const_cast<double *>(&value); }
+            static double load(void *value) { return *static_cast<double *>(value); }
+        };
+
+        struct double_traits
+        {
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const double &value)
+            {
+                return double_format(buffer, bufferSize, format, double_storage<>::argument(value));
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_spec &spec, const double &value)
+            {
+                return double_format(buffer, bufferSize, spec, double_storage<>::argument(value));
+            }
+        };
+
+        struct timestamp_traits
+        {
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const timestamp &value)
+            {
+                return timestamp_format(buffer, bufferSize, format, value);
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_spec &spec, const timestamp &value)
+            {
+                return timestamp_format(buffer, bufferSize, spec, value);
+            }
+        };
+
+        /// Strings with known length are formatted without scanning for terminating zero
+        struct string_view_traits
+        {
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const string_view &value)
+            {
+                return char_str_format(buffer, bufferSize, format, value.data(), value.size());
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_spec &spec, const string_view &value)
+            {
+                return char_str_format(buffer, bufferSize, spec, value.data(), value.size());
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const wstring_view &value)
+            {
+                return wchar_t_str_format(buffer, bufferSize, format, value.data(), value.size());
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_spec &spec, const wstring_view &value)
+            {
+                return wchar_t_str_format(buffer, bufferSize, spec, value.data(), value.size());
+            }
+        };
+    }
+
+    /// \brief Type-erased value with its formatting function.
+    ///
+    /// Values up to 24 bytes are stored inside of formatter, so formatters
+    /// of built-in types are created without heap allocation. Formatter is movable, but not copyable.
     class formatter
     {
     public:
-        typedef size_t (*format_value)(char *buffer, size_t bufferSize, const format_options *format, void *value);
+        typedef detail::format_value_function format_value;
         typedef void (*clean_value)(void *value);
 
+        formatter()
+            : _vtable(nullptr)
+        {}
+
         formatter(ptrdiff_t value)
+            : _vtable(&detail::pointer_value<&signed_integer_format, &signed_integer_format>::vtable)
         {
-            _value = reinterpret_cast<void*>(value);
-            _format = &signed_integer_format;
-            _clean = nullptr;
-        };
+            _storage.pointer = reinterpret_cast<void*>(value);
+        }
 
         formatter(size_t value)
+            : _vtable(&detail::pointer_value<&unsigned_integer_format, &unsigned_integer_format>::vtable)
         {
-            _value = reinterpret_cast<void*>(value);
-            _format = &unsigned_integer_format;
-            _clean = nullptr;
-        };
+            _storage.pointer = reinterpret_cast<void*>(value);
+        }
 
+        /// \brief Formatter for value of built-in type packed into void*.
+        ///
+        /// Value is formatted by \c Format with format options or by \c FormatSpec with compiled specification.
+        template <format_value Format, detail::format_spec_function FormatSpec>
+        static formatter packed(void *value)
+        {
+            formatter result;
+            result._storage.pointer = value;
+            result._vtable = &detail::pointer_value<Format, FormatSpec>::vtable;
+            return result;
+        }
+
+        /// \brief Formatter for value packed into void*.
+        /// \param cleaner - called for non-null value on destruction, may be nullptr
         formatter(void *value, format_value formatter, clean_value cleaner)
+            : _vtable(&detail::function_value::vtable)
+        {
+            static_assert(sizeof(detail::function_value) <= sizeof(detail::formatter_storage), "formatter storage is too small");
+            detail::function_value *v = new (&_storage) detail::function_value;
+            v->value = value;
+            v->format = formatter;
+            v->clean = cleaner;
+        }
+
+        formatter(formatter &&other)
+            : _vtable(other._vtable)
         {
-            _value = value;
-            _format = formatter;
-            _clean = cleaner;
+            move_from(other);
+        }
+
+        formatter &operator=(formatter &&other)
+        {
+            if (this != &other)
+            {
+                reset();
+                _vtable = other._vtable;
+                move_from(other);
+            }
+            return *this;
         }
 
         ~formatter()
         {
-            if (_clean && _value)
-                _clean(_value);
+            reset();
+        }
+
+        /// \brief Create formatter for value of any type.
+        ///
+        /// Value is formatted by \c Traits::format(char*,size_t,const format_options*,const T&),
+        /// it's stored inside of formatter if it fits, otherwise on heap.
+        template <class Traits, class T>
+        static formatter create(T &&value)
+        {
+            typedef typename std::decay<T>::type value_type;
+            typedef typename std::conditional<detail::fits_formatter_storage<value_type>::value,
+                detail::inline_value<value_type, Traits>,
+                detail::heap_value<value_type, Traits> >::type holder;
+
+            formatter result;
+            holder::construct(&result._storage, std::forward<T>(value));
+            result._vtable = &holder::vtable;
+            return result;
+        }
+
+        size_t format(char *buffer, size_t bufferSize, const format_options *format = nullptr) const
+        {
+            if (_vtable)
+                return _vtable->format(buffer, bufferSize, format, &_storage);
+            return 0;
         }
 
-        size_t format(char *buffer, size_t bufferSize, const format_options *format = nullptr)
+        size_t format(char *buffer, size_t bufferSize, const format_spec &spec) const
         {
-            if (_format)
-                return _format(buffer, bufferSize, format, _value);
+            if (_vtable)
+                return _vtable->format_with_spec(buffer, bufferSize, spec, &_storage);
             return 0;
         }
 
+        /// Count of characters (without terminating zero) required to format value
+        size_t size(const format_options *format = nullptr) const
+        {
+            return this->format(nullptr, 0, format);
+        }
+
+        size_t size(const format_spec &spec) const
+        {
+            return format(nullptr, 0, spec);
+        }
+
     private:
-        void *_value;
-        format_value _format;
-        clean_value _clean;
+        formatter(const formatter &) = delete;
+        formatter &operator=(const formatter &) = delete;
+
+        void move_from(formatter &other)
+        {
+            if (_vtable && _vtable->move)
+                _vtable->move(&_storage, &other._storage);
+            else
+                _storage = other._storage;
+            other._vtable = nullptr;
+        }
+
+        void reset()
+        {
+            if (_vtable && _vtable->destroy)
+                _vtable->destroy(&_storage);
+            _vtable = nullptr;
+        }
+
+        const detail::formatter_vtable *_vtable;
+        detail::formatter_storage _storage;
     };
 
     inline formatter get_formatter(int8_t value) { return formatter((ptrdiff_t)value); }
@@ -77,41 +568,198 @@ namespace strings
     inline formatter get_formatter(uint16_t value) { return formatter((size_t)value); }
     inline formatter get_formatter(uint32_t value) { return formatter((size_t)value); }
     inline formatter get_formatter(uint64_t value) { return formatter((size_t)value); }
+    inline formatter get_formatter(double value) {
+        return formatter::create<detail::double_traits>(value);
+    }
+    inline formatter get_formatter(float value) {
+        void *v = nullptr;
+        memcpy(&v, &value, sizeof(value));
+        return formatter::packed<&float_format, &float_format>(v);
+    }
     inline formatter get_formatter(bool value) {
-        return formatter(reinterpret_cast<void*>(value), &bool_format, nullptr);
+        return formatter::packed<&bool_format, &bool_format>(reinterpret_cast<void*>(value));
     }
     inline formatter get_formatter(char value) {
-        return formatter(reinterpret_cast<void*>(value), &char_format, nullptr);
+        return formatter::packed<&char_format, &char_format>(reinterpret_cast<void*>(value));
     }
     inline formatter get_formatter(wchar_t value) {
-        return formatter(reinterpret_cast<void*>(value), &wchar_t_format, nullptr);
+        return formatter::packed<&wchar_t_format, &wchar_t_format>(reinterpret_cast<void*>(value));
     }
     inline formatter get_formatter(char *value) {
-        return formatter(reinterpret_cast<void*>(value), &char_str_format, nullptr);
+        return formatter::packed<&char_str_format, &char_str_format>(reinterpret_cast<void*>(value));
     }
     inline formatter get_formatter(wchar_t *value) {
-        return formatter(reinterpret_cast<void*>(value), &wchar_t_str_format, nullptr);
+        return formatter::packed<&wchar_t_str_format, &wchar_t_str_format>(reinterpret_cast<void*>(value));
     }
     inline formatter get_formatter(const char *value) {
-        return formatter(reinterpret_cast<void*>(const_cast<char*>(value)), &char_str_format, nullptr);
+        return formatter::packed<&char_str_format, &char_str_format>(reinterpret_cast<void*>(const_cast<char*>(value)));
     }
     inline formatter get_formatter(const wchar_t *value) {
-        return formatter(reinterpret_cast<void*>(const_cast<wchar_t*>(value)), &wchar_t_str_format, nullptr);
+        return formatter::packed<&wchar_t_str_format, &wchar_t_str_format>(reinterpret_cast<void*>(const_cast<wchar_t*>(value)));
     }
 
     template<typename _CharT, typename _Traits, typename _Alloc>
     inline formatter get_formatter(const std::basic_string<_CharT, _Traits, _Alloc> &stringValue) {
-        const _CharT *str = stringValue.c_str();
-        return get_formatter(str);
+        return formatter::create<detail::string_view_traits>(basic_string_view<_CharT>(stringValue.data(), stringValue.size()));
+    }
+    inline formatter get_formatter(const timestamp &value) {
+        return formatter::create<detail::timestamp_traits>(value);
     }
+    inline formatter get_formatter(const string_view &value) {
+        return formatter::create<detail::string_view_traits>(value);
+    }
+    inline formatter get_formatter(const wstring_view &value) {
+        return formatter::create<detail::string_view_traits>(value);
+    }
+#if __cplusplus >= 201703L
+    template<typename _CharT, typename _Traits>
+    inline formatter get_formatter(std::basic_string_view<_CharT, _Traits> value) {
+        return formatter::create<detail::string_view_traits>(basic_string_view<_CharT>(value.data(), value.size()));
+    }
+#endif
 
     template <class T>
     inline formatter get_formatter(T *value) {
-        return formatter(reinterpret_cast<void*>(value), &pointer_format, nullptr);
+        return formatter::packed<&pointer_format, &pointer_format>(reinterpret_cast<void*>(value));
     }
     template <class T>
     inline formatter get_formatter(const T *value) {
-        return formatter(reinterpret_cast<void*>(const_cast<T*>(value)), &pointer_format, nullptr);
+        return formatter::packed<&pointer_format, &pointer_format>(reinterpret_cast<void*>(const_cast<T*>(value)));
+    }
+
+    /// \brief Customization point for formatting of user types.
+    ///
+    /// Specialization should provide function, which appends formatted value to sink
+    /// (see sinks.h), and may provide function, which returns exact length of formatted value,
+    /// so measuring doesn't need formatting:
+    ///
+    /// ~~~{.c}
+    /// template <>
+    /// struct strings::formatter_traits<order_id>
+    /// {
+    ///     template <class Sink>
+    ///     static void format(Sink &sink, const order_id &value, const strings::format_spec &spec)
+    ///     {
+    ///         strings::format_to(sink, "{}-{:08x}", value.venue, value.sequence);
+    ///     }
+    ///
+    ///     static size_t size(const order_id &value, const strings::format_spec &spec);   // optional
+    /// };
+    /// ~~~
+    ///
+    /// get_formatter() accepts values of every type with formatter_traits specialization,
+    /// value is copied into formatter. Field width from format specification is applied
+    /// to formatted value, if traits produce shorter text.
+    template <class T, class Enable = void>
+    struct formatter_traits
+    {
+        typedef void not_specialized;
+    };
+
+    namespace detail
+    {
+        template <class T>
+        struct has_formatter_traits
+        {
+            template <class U> static char test(typename formatter_traits<U>::not_specialized *);
+            template <class U> static long test(...);
+            static const bool value = sizeof(test<T>(nullptr)) != sizeof(char);
+        };
+
+        template <class T>
+        struct has_formatter_traits_size
+        {
+            template <class U> static char test(decltype(formatter_traits<U>::size(std::declval<const U &>(), std::declval<const format_spec &>())) *);
+            template <class U> static long test(...);
+            static const bool value = sizeof(test<T>(nullptr)) == sizeof(char);
+        };
+
+        /// \brief Convert wide characters to UTF-8 in single pass, stop at first code point which doesn't fit or is invalid.
+        /// \param limit - size of buffer including terminating zero
+        /// \return count of written bytes, or count of bytes required if buffer is nullptr
+        size_t narrow(char *buffer, size_t limit, const wchar_t *begin, const wchar_t *end);
+
+        size_t pad_in_place(char *buffer, size_t bufferSize, size_t length, const format_spec &spec);
+
+        /// \brief Sink over formatter output buffer, which keeps characters fitting into buffer and counts all of them.
+        /// Buffer is nullptr in measuring mode, otherwise buffer size should be non-zero.
+        class formatter_sink
+        {
+        public:
+            typedef char char_t;
+
+            formatter_sink(char *buffer, size_t bufferSize)
+                : _buffer(buffer)
+                , _capacity(buffer != nullptr ? bufferSize - 1 : 0)
+                , _size(0)
+            {}
+
+            void reserve(size_t) {}
+
+            void append(const char_t *source, size_t sourceSize)
+            {
+                if (_size < _capacity)
+                    memcpy(_buffer + _size, source, sourceSize < _capacity - _size ? sourceSize : _capacity - _size);
+                _size += sourceSize;
+            }
+
+            size_t size() const { return _size; }
+
+            /// Terminate buffer, return count of written characters, or count of all characters in measuring mode
+            size_t finish()
+            {
+                if (_buffer == nullptr)
+                    return _size;
+                size_t written = _size < _capacity ? _size : _capacity;
+                _buffer[written] = '\0';
+                return written;
+            }
+
+        private:
+            char_t *_buffer;
+            size_t _capacity;
+            size_t _size;
+        };
+
+        /// Adapts formatter_traits<T> to formatter storage
+        template <class T>
+        struct user_traits
+        {
+            static size_t format(char *buffer, size_t bufferSize, const format_options *format, const T &value)
+            {
+                return user_traits::format(buffer, bufferSize, format != nullptr ? format->get_spec() : default_format_spec(), value);
+            }
+
+            static size_t format(char *buffer, size_t bufferSize, const format_spec &spec, const T &value)
+            {
+                if (buffer != nullptr && bufferSize == 0)
+                    return 0;
+                if (buffer == nullptr)
+                    return measure(value, spec, std::integral_constant<bool, has_formatter_traits_size<T>::value>());
+
+                formatter_sink sink(buffer, bufferSize);
+                formatter_traits<T>::format(sink, value, spec);
+                return pad_in_place(buffer, bufferSize, sink.finish(), spec);
+            }
+
+            static size_t measure(const T &value, const format_spec &spec, std::true_type)
+            {
+                return pad_in_place(nullptr, 0, formatter_traits<T>::size(value, spec), spec);
+            }
+
+            static size_t measure(const T &value, const format_spec &spec, std::false_type)
+            {
+                formatter_sink sink(nullptr, 0);
+                formatter_traits<T>::format(sink, value, spec);
+                return pad_in_place(nullptr, 0, sink.finish(), spec);
+            }
+        };
+    }
+
+    template <class T>
+    inline formatter get_formatter(const T &value,
+        typename std::enable_if<detail::has_formatter_traits<T>::value>::type * = nullptr) {
+        return formatter::create<detail::user_traits<T> >(value);
     }
 }
 
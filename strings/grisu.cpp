@@ -0,0 +1,247 @@
+/// \file
+///
+/// Grisu2 algorithm by Florian Loitsch, see article
+/// [Printing Floating-Point Numbers Quickly and Accurately with Integers](http://florian.loitsch.com/publications/dtoa-pldi2010.pdf).
+///
+/// Implementation is based on [dtoa-benchmark by Milo Yip](https://github.com/miloyip/dtoa-benchmark)
+/// and slightly modified to fit common-tools code style.
+#include "grisu.h"
+#include <cstdint>
+#include <cstring>
+
+namespace strings
+{
+    namespace detail
+    {
+        /// Do-It-Yourself floating point: f * 2^e
+        struct diy_fp
+        {
+            uint64_t f;
+            int e;
+
+            diy_fp() : f(), e() {}
+            diy_fp(uint64_t fp, int exp) : f(fp), e(exp) {}
+
+            diy_fp operator-(const diy_fp &rhs) const
+            {
+                return diy_fp(f - rhs.f, e);
+            }
+
+            diy_fp operator*(const diy_fp &rhs) const
+            {
+                const uint64_t M32 = 0xFFFFFFFF;
+                const uint64_t a = f >> 32;
+                const uint64_t b = f & M32;
+                const uint64_t c = rhs.f >> 32;
+                const uint64_t d = rhs.f & M32;
+                const uint64_t ac = a * c;
+                const uint64_t bc = b * c;
+                const uint64_t ad = a * d;
+                const uint64_t bd = b * d;
+                uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+                tmp += 1U << 31; // round
+                return diy_fp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+            }
+
+            diy_fp normalize() const
+            {
+                diy_fp res = *this;
+                while (!(res.f & (uint64_t(1) << 63)))
+                {
+                    res.f <<= 1;
+                    res.e--;
+                }
+                return res;
+            }
+        };
+
+        /// Normalized 10^k for k = -348, -340, ..., 340
+        inline diy_fp get_cached_power(int e, int &K)
+        {
+            static const uint64_t cached_powers_f[] = {
+                0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+                0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+                0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+                0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+                0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+                0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+                0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+                0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+                0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+                0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+                0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+                0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+                0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+                0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+                0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+                0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+                0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+                0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+                0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+                0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+                0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+                0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+                0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+                0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+                0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+                0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+                0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+                0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+                0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+            };
+            static const int16_t cached_powers_e[] = {
+                -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+                -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+                -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+                -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+                56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+                375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+                694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+                1013, 1039, 1066,
+            };
+
+            double dk = (-61 - e) * 0.30102999566398114 + 347; // dk must be positive, so can do ceiling in positive
+            int k = static_cast<int>(dk);
+            if (dk - k > 0.0)
+                k++;
+
+            unsigned index = static_cast<unsigned>((k >> 3) + 1);
+            K = -(-348 + static_cast<int>(index << 3)); // decimal exponent no need lookup table
+
+            return diy_fp(cached_powers_f[index], cached_powers_e[index]);
+        }
+
+        inline void grisu_round(char *buffer, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+        {
+            while (rest < wp_w && delta - rest >= ten_kappa &&
+                   (rest + ten_kappa < wp_w || // closer
+                    wp_w - rest > rest + ten_kappa - wp_w))
+            {
+                buffer[len - 1]--;
+                rest += ten_kappa;
+            }
+        }
+
+        inline int count_decimal_digits(uint32_t n)
+        {
+            if (n < 10) return 1;
+            if (n < 100) return 2;
+            if (n < 1000) return 3;
+            if (n < 10000) return 4;
+            if (n < 100000) return 5;
+            if (n < 1000000) return 6;
+            if (n < 10000000) return 7;
+            if (n < 100000000) return 8;
+            if (n < 1000000000) return 9;
+            return 10;
+        }
+
+        inline void digit_gen(const diy_fp &W, const diy_fp &Mp, uint64_t delta, char *buffer, int &len, int &K)
+        {
+            static const uint32_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+            const diy_fp one(uint64_t(1) << -Mp.e, Mp.e);
+            const diy_fp wp_w = Mp - W;
+            uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+            uint64_t p2 = Mp.f & (one.f - 1);
+            int kappa = count_decimal_digits(p1);
+            len = 0;
+
+            while (kappa > 0)
+            {
+                uint32_t d = p1 / pow10[kappa - 1];
+                p1 %= pow10[kappa - 1];
+                if (d || len)
+                    buffer[len++] = static_cast<char>('0' + d);
+                kappa--;
+                uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+                if (tmp <= delta)
+                {
+                    K += kappa;
+                    grisu_round(buffer, len, delta, tmp, static_cast<uint64_t>(pow10[kappa]) << -one.e, wp_w.f);
+                    return;
+                }
+            }
+
+            // kappa = 0
+            for (;;)
+            {
+                p2 *= 10;
+                delta *= 10;
+                char d = static_cast<char>(p2 >> -one.e);
+                if (d || len)
+                    buffer[len++] = static_cast<char>('0' + d);
+                p2 &= one.f - 1;
+                kappa--;
+                if (p2 < delta)
+                {
+                    K += kappa;
+                    static const uint64_t pow10_64[] = {
+                        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+                        1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+                        1000000000000000000ULL, 10000000000000000000ULL
+                    };
+                    int index = -kappa;
+                    grisu_round(buffer, len, delta, p2, one.f, wp_w.f * (index < 20 ? pow10_64[index] : 0));
+                    return;
+                }
+            }
+        }
+
+        /// \param v - value decoded from IEEE-754 representation
+        /// \param lowerBoundaryIsCloser - true if value is power of two, so distance
+        ///        to previous representable value is half of distance to next one
+        inline int grisu2(const diy_fp &v, bool lowerBoundaryIsCloser, char *digits, int &exponent)
+        {
+            diy_fp w_p = diy_fp((v.f << 1) + 1, v.e - 1).normalize();
+            diy_fp w_m = lowerBoundaryIsCloser ? diy_fp((v.f << 2) - 1, v.e - 2) : diy_fp((v.f << 1) - 1, v.e - 1);
+            w_m.f <<= w_m.e - w_p.e;
+            w_m.e = w_p.e;
+
+            const diy_fp c_mk = get_cached_power(w_p.e, exponent);
+            const diy_fp W = v.normalize() * c_mk;
+            diy_fp Wp = w_p * c_mk;
+            diy_fp Wm = w_m * c_mk;
+            Wm.f++;
+            Wp.f--;
+
+            int length = 0;
+            digit_gen(W, Wp, Wp.f - Wm.f, digits, length, exponent);
+            return length;
+        }
+
+        int grisu2(double value, char *digits, int &exponent)
+        {
+            const int significandSize = 52;
+            const int exponentBias = 0x3FF + significandSize;
+            const uint64_t hiddenBit = uint64_t(1) << significandSize;
+
+            uint64_t u;
+            memcpy(&u, &value, sizeof(u));
+            int biasedExponent = int((u >> significandSize) & 0x7FF);
+            uint64_t significand = u & (hiddenBit - 1);
+
+            diy_fp v = biasedExponent != 0
+                ? diy_fp(significand + hiddenBit, biasedExponent - exponentBias)
+                : diy_fp(significand, 1 - exponentBias);
+            return grisu2(v, significand == 0 && biasedExponent > 1, digits, exponent);
+        }
+
+        int grisu2(float value, char *digits, int &exponent)
+        {
+            const int significandSize = 23;
+            const int exponentBias = 0x7F + significandSize;
+            const uint32_t hiddenBit = uint32_t(1) << significandSize;
+
+            uint32_t u;
+            memcpy(&u, &value, sizeof(u));
+            int biasedExponent = int((u >> significandSize) & 0xFF);
+            uint32_t significand = u & (hiddenBit - 1);
+
+            diy_fp v = biasedExponent != 0
+                ? diy_fp(significand + hiddenBit, biasedExponent - exponentBias)
+                : diy_fp(significand, 1 - exponentBias);
+            return grisu2(v, significand == 0 && biasedExponent > 1, digits, exponent);
+        }
+    }
+}
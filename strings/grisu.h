@@ -0,0 +1,22 @@
+#ifndef __GRISU_HEADER_H__
+#define __GRISU_HEADER_H__
+
+namespace strings
+{
+    namespace detail
+    {
+        /// Maximal count of digits generated by \ref grisu2()
+        const int grisu_max_digits = 18;
+
+        /// \brief Shortest round-trip decimal representation of floating point value.
+        /// \param [in]  value    - positive finite value
+        /// \param [out] digits   - buffer for at least \ref grisu_max_digits decimal digits (not null-terminated)
+        /// \param [out] exponent - decimal exponent: value == digits * 10^exponent
+        /// \return Count of generated digits
+        int grisu2(double value, char *digits, int &exponent);
+        /// \overload
+        int grisu2(float value, char *digits, int &exponent);
+    }
+}
+
+#endif
@@ -0,0 +1,261 @@
+#include "hashing_sink.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define STRINGS_HASHING_CRC32_INSTRUCTION
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#       include <nmmintrin.h>
+#       define STRINGS_HASHING_TARGET_SSE42
+#   else
+#       include <cpuid.h>
+#       include <nmmintrin.h>
+#       define STRINGS_HASHING_TARGET_SSE42 __attribute__((target("sse4.2")))
+#   endif
+#endif
+
+// XXH64
+namespace strings
+{
+    namespace
+    {
+        const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+        const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+        const uint64_t prime3 = 0x165667B19E3779F9ULL;
+        const uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+        const uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+        inline uint64_t rotate_left(uint64_t value, unsigned bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        inline uint64_t read64(const unsigned char *p)
+        {
+            uint64_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t read32(const unsigned char *p)
+        {
+            uint32_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t xxh_round(uint64_t accumulator, uint64_t input)
+        {
+            accumulator += input * prime2;
+            accumulator = rotate_left(accumulator, 31);
+            return accumulator * prime1;
+        }
+
+        inline uint64_t merge_round(uint64_t accumulator, uint64_t value)
+        {
+            accumulator ^= xxh_round(0, value);
+            return accumulator * prime1 + prime4;
+        }
+
+        /// Process 32-byte stripes, return pointer after last processed stripe
+        const unsigned char *process_stripes(uint64_t (&state)[4], const unsigned char *p, const unsigned char *end)
+        {
+            uint64_t v1 = state[0], v2 = state[1], v3 = state[2], v4 = state[3];
+            for (; end - p >= 32; p += 32)
+            {
+                v1 = xxh_round(v1, read64(p));
+                v2 = xxh_round(v2, read64(p + 8));
+                v3 = xxh_round(v3, read64(p + 16));
+                v4 = xxh_round(v4, read64(p + 24));
+            }
+            state[0] = v1;
+            state[1] = v2;
+            state[2] = v3;
+            state[3] = v4;
+            return p;
+        }
+    }
+
+    xxhash64::xxhash64(uint64_t seed)
+        : _seed(seed)
+        , _total(0)
+        , _buffered(0)
+    {
+        _state[0] = seed + prime1 + prime2;
+        _state[1] = seed + prime2;
+        _state[2] = seed;
+        _state[3] = seed - prime1;
+    }
+
+    void xxhash64::update(const void *data, size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        const unsigned char *end = p + size;
+        _total += size;
+
+        if (_buffered + size < 32)
+        {
+            memcpy(_buffer + _buffered, p, size);
+            _buffered += size;
+            return;
+        }
+
+        if (_buffered != 0)
+        {
+            size_t count = 32 - _buffered;
+            memcpy(_buffer + _buffered, p, count);
+            process_stripes(_state, _buffer, _buffer + 32);
+            p += count;
+            _buffered = 0;
+        }
+
+        p = process_stripes(_state, p, end);
+        _buffered = size_t(end - p);
+        memcpy(_buffer, p, _buffered);
+    }
+
+    uint64_t xxhash64::digest() const
+    {
+        uint64_t hash;
+        if (_total >= 32)
+        {
+            hash = rotate_left(_state[0], 1) + rotate_left(_state[1], 7) + rotate_left(_state[2], 12) + rotate_left(_state[3], 18);
+            for (size_t i = 0; i < 4; ++i)
+                hash = merge_round(hash, _state[i]);
+        }
+        else
+        {
+            hash = _seed + prime5;
+        }
+        hash += _total;
+
+        const unsigned char *p = _buffer;
+        const unsigned char *end = _buffer + _buffered;
+        for (; end - p >= 8; p += 8)
+            hash = rotate_left(hash ^ xxh_round(0, read64(p)), 27) * prime1 + prime4;
+        if (end - p >= 4)
+        {
+            hash = rotate_left(hash ^ (uint64_t(read32(p)) * prime1), 23) * prime2 + prime3;
+            p += 4;
+        }
+        for (; p != end; ++p)
+            hash = rotate_left(hash ^ (*p * prime5), 11) * prime1;
+
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        hash *= prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
+
+// CRC32C
+namespace strings
+{
+    namespace
+    {
+        /// Tables for slicing-by-8 software implementation
+        struct crc32c_tables
+        {
+            uint32_t values[8][256];
+
+            crc32c_tables()
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    uint32_t crc = i;
+                    for (int bit = 0; bit < 8; ++bit)
+                        crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+                    values[0][i] = crc;
+                }
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    for (int table = 1; table < 8; ++table)
+                        values[table][i] = (values[table - 1][i] >> 8) ^ values[0][values[table - 1][i] & 0xFF];
+                }
+            }
+        };
+
+        const crc32c_tables &get_crc32c_tables()
+        {
+            static const crc32c_tables tables;
+            return tables;
+        }
+
+        uint32_t software_crc32c(uint32_t crc, const unsigned char *p, size_t size)
+        {
+            const crc32c_tables &tables = get_crc32c_tables();
+            for (; size >= 8; size -= 8, p += 8)
+            {
+                uint32_t low = read32(p) ^ crc;
+                uint32_t high = read32(p + 4);
+                crc = tables.values[7][low & 0xFF] ^ tables.values[6][(low >> 8) & 0xFF] ^
+                      tables.values[5][(low >> 16) & 0xFF] ^ tables.values[4][low >> 24] ^
+                      tables.values[3][high & 0xFF] ^ tables.values[2][(high >> 8) & 0xFF] ^
+                      tables.values[1][(high >> 16) & 0xFF] ^ tables.values[0][high >> 24];
+            }
+            for (; size != 0; --size, ++p)
+                crc = (crc >> 8) ^ tables.values[0][(crc ^ *p) & 0xFF];
+            return crc;
+        }
+
+#if defined(STRINGS_HASHING_CRC32_INSTRUCTION)
+        bool has_sse42()
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+#else
+            unsigned eax, ebx, ecx, edx;
+            return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_SSE4_2) != 0;
+#endif
+        }
+
+        bool get_sse42()
+        {
+            static const bool sse42 = has_sse42();
+            return sse42;
+        }
+
+        STRINGS_HASHING_TARGET_SSE42
+        uint32_t hardware_crc32c(uint32_t crc, const unsigned char *p, size_t size)
+        {
+#if defined(_M_X64) || defined(__x86_64__)
+            uint64_t crc64 = crc;
+            for (; size >= 8; size -= 8, p += 8)
+                crc64 = _mm_crc32_u64(crc64, read64(p));
+            crc = uint32_t(crc64);
+#endif
+            for (; size >= 4; size -= 4, p += 4)
+                crc = _mm_crc32_u32(crc, read32(p));
+            for (; size != 0; --size, ++p)
+                crc = _mm_crc32_u8(crc, *p);
+            return crc;
+        }
+#endif
+    }
+
+    void crc32c::update(const void *data, size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+#if defined(STRINGS_HASHING_CRC32_INSTRUCTION)
+        if (get_sse42())
+        {
+            _crc = hardware_crc32c(_crc, p, size);
+            return;
+        }
+#endif
+        _crc = software_crc32c(_crc, p, size);
+    }
+
+    bool crc32c::hardware()
+    {
+#if defined(STRINGS_HASHING_CRC32_INSTRUCTION)
+        return get_sse42();
+#else
+        return false;
+#endif
+    }
+}
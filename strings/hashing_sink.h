@@ -0,0 +1,102 @@
+#ifndef __HASHING_SINK_HEADER_H__
+#define __HASHING_SINK_HEADER_H__
+
+/// \file
+///
+/// Sink adaptor, which computes checksums of content while forwarding it to another sink,
+/// so formatted output and its digest are produced in single pass:
+///
+/// ~~~{.c}
+/// std::string text;
+/// strings::hashing_sink<std::string> sink(text);
+/// strings::format_to(sink, "{}: {}", name, value);
+/// uint64_t key = sink.hash();
+/// uint32_t checksum = sink.crc();
+/// ~~~
+
+#include <cstddef>
+#include <cstdint>
+
+namespace strings
+{
+    /// \brief Incremental XXH64 hash.
+    class xxhash64
+    {
+    public:
+        explicit xxhash64(uint64_t seed = 0);
+
+        void update(const void *data, size_t size);
+
+        /// Hash of all data passed to update (update may be called after it)
+        uint64_t digest() const;
+
+    private:
+        uint64_t _state[4];
+        uint64_t _seed;
+        uint64_t _total;
+        unsigned char _buffer[32];
+        size_t _buffered;
+    };
+
+    /// \brief Incremental CRC32C (Castagnoli), uses SSE4.2 crc32 instruction if processor supports it.
+    class crc32c
+    {
+    public:
+        crc32c()
+            : _crc(0xFFFFFFFF)
+        {}
+
+        void update(const void *data, size_t size);
+
+        uint32_t value() const { return ~_crc; }
+
+        /// Processor supports crc32 instruction, which is used by update
+        static bool hardware();
+
+    private:
+        uint32_t _crc;
+    };
+
+    /// \brief Sink adaptor, which forwards content to sink and hashes it with XXH64 and CRC32C.
+    template <class Sink>
+    class hashing_sink
+    {
+    public:
+        typedef char char_t;
+
+        explicit hashing_sink(Sink &sink, uint64_t seed = 0)
+            : _sink(sink)
+            , _hash(seed)
+        {}
+
+        void reserve(size_t size)
+        {
+            _sink.reserve(size);
+        }
+
+        void append(const char_t *source, size_t sourceSize)
+        {
+            _hash.update(source, sourceSize);
+            _crc.update(source, sourceSize);
+            _sink.append(source, sourceSize);
+        }
+
+        size_t size() const { return _sink.size(); }
+
+        /// XXH64 of content appended through adaptor
+        uint64_t hash() const { return _hash.digest(); }
+
+        /// CRC32C of content appended through adaptor
+        uint32_t crc() const { return _crc.value(); }
+
+    private:
+        hashing_sink(const hashing_sink &) = delete;
+        hashing_sink &operator=(const hashing_sink &) = delete;
+
+        Sink &_sink;
+        xxhash64 _hash;
+        crc32c _crc;
+    };
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __HEX_DIGITS_HEADER_H__
+#define __HEX_DIGITS_HEADER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace strings
+{
+    namespace detail
+    {
+        /// Hexadecimal digits table: lowercase digits at [0, 16), uppercase digits at [16, 32)
+        static const char hex_digits[] = "0123456789abcdef0123456789ABCDEF";
+
+        /// Uppercase hexadecimal digit of low nibble of byte
+        inline char get_digit(unsigned char byte)
+        {
+            return hex_digits[16 + (byte & 0xf)];
+        }
+
+        /// Count of hexadecimal digits of value without leading zeros (1 for zero)
+        inline size_t hex_digits_count(uint64_t value)
+        {
+#if defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            return _BitScanReverse64(&index, value | 1) ? size_t(index / 4 + 1) : 1;
+#elif defined(__GNUC__)
+            return size_t((63 - __builtin_clzll(value | 1)) / 4 + 1);
+#else
+            size_t count = 1;
+            while (value >>= 4)
+                ++count;
+            return count;
+#endif
+        }
+
+        /// \brief Write exactly count hexadecimal digits of value backward from end.
+        /// \return pointer to first digit
+        inline char *format_hex(char *end, uint64_t value, size_t count, bool upper)
+        {
+            const char *digits = hex_digits + (upper ? 16 : 0);
+            for (; count >= 2; count -= 2)
+            {
+                unsigned byte = unsigned(value & 0xff);
+                value >>= 8;
+                *--end = digits[byte & 0xf];
+                *--end = digits[byte >> 4];
+            }
+            if (count != 0)
+                *--end = digits[value & 0xf];
+            return end;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "ring_sink.h"
+#include <algorithm>
+#include <cstring>
+
+namespace strings
+{
+    namespace
+    {
+        size_t round_capacity(size_t capacity)
+        {
+            size_t result = 64;
+            while (result < capacity)
+                result <<= 1;
+            return result;
+        }
+    }
+
+    byte_ring::byte_ring(size_t capacity)
+        : _data(new char[round_capacity(capacity)])
+        , _mask(round_capacity(capacity) - 1)
+        , _dropped(0)
+        , _head(0)
+        , _cachedTail(0)
+        , _tail(0)
+    {
+    }
+
+    size_t byte_ring::writable() const
+    {
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        return capacity() - (_head.load(std::memory_order_relaxed) - _cachedTail);
+    }
+
+    bool byte_ring::fits(size_t size) const
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (capacity() - (head - _cachedTail) >= size)
+            return true;
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        return capacity() - (head - _cachedTail) >= size;
+    }
+
+    void byte_ring::write(size_t offset, const char *data, size_t size)
+    {
+        size_t position = (_head.load(std::memory_order_relaxed) + offset) & _mask;
+        size_t first = std::min(size, capacity() - position);
+        memcpy(_data.get() + position, data, first);
+        memcpy(_data.get(), data + first, size - first);
+    }
+
+    void byte_ring::publish(size_t size)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    size_t byte_ring::peek(string_view (&spans)[2]) const
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t size = _head.load(std::memory_order_acquire) - tail;
+        size_t position = tail & _mask;
+        size_t first = std::min(size, capacity() - position);
+        spans[0] = string_view(_data.get() + position, first);
+        spans[1] = string_view(_data.get(), size - first);
+        return size == 0 ? 0 : size == first ? 1 : 2;
+    }
+
+    void byte_ring::consume(size_t size)
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    size_t byte_ring::readable() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+}
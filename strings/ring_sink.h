@@ -0,0 +1,160 @@
+#ifndef __RING_SINK_HEADER_H__
+#define __RING_SINK_HEADER_H__
+
+/// \file
+///
+/// Lock-free handoff of formatted records from one producer thread to one consumer thread.
+///
+/// Producer formats record into ring_sink, which publishes it on commit (or destruction),
+/// consumer drains contiguous spans of published records, e.g. for writing to file:
+///
+/// ~~~{.c}
+/// strings::byte_ring ring(1 << 20);
+///
+/// // producer thread
+/// {
+///     strings::ring_sink sink(ring);
+///     strings::format_to(sink, "{}: {}\n", name, value);
+/// }
+///
+/// // consumer thread
+/// strings::string_view spans[2];
+/// size_t count = ring.peek(spans);
+/// for (size_t i = 0; i < count; ++i)
+///     write(fd, spans[i].data(), spans[i].size());
+/// ring.consume(spans[0].size() + (count > 1 ? spans[1].size() : 0));
+/// ~~~
+
+#include "string_view.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace strings
+{
+    /// \brief Single-producer single-consumer lock-free byte ring.
+    ///
+    /// Records are published whole, so consumer never sees partially written record.
+    /// Records are stored without framing, so published content is drained as byte stream.
+    class byte_ring
+    {
+    public:
+        /// \param capacity - capacity in bytes, rounded up to power of two
+        explicit byte_ring(size_t capacity = 64 * 1024);
+
+        size_t capacity() const { return _mask + 1; }
+
+        // producer interface
+
+        /// Count of bytes available for writing
+        size_t writable() const;
+
+        /// \brief Check that size bytes are available for writing.
+        ///
+        /// Unlike \ref writable(), it reads consumer position only when last known one isn't enough.
+        bool fits(size_t size) const;
+
+        /// \brief Copy data to unpublished area at offset from end of published content.
+        /// \note Caller checks that offset + size <= writable()
+        void write(size_t offset, const char *data, size_t size);
+
+        /// Make next size bytes of written data visible to consumer
+        void publish(size_t size);
+
+        // consumer interface
+
+        /// \brief Get published content as one or two contiguous spans (content may wrap around end of ring).
+        /// \return count of non-empty spans
+        size_t peek(string_view (&spans)[2]) const;
+
+        /// Release size bytes of published content for reuse by producer
+        void consume(size_t size);
+
+        /// Count of published and not consumed bytes
+        size_t readable() const;
+
+        /// Count of records dropped because ring was full
+        size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    private:
+        friend class ring_sink;
+
+        byte_ring(const byte_ring &) = delete;
+        byte_ring &operator=(const byte_ring &) = delete;
+
+        std::unique_ptr<char[]> _data;
+        size_t _mask;
+        std::atomic<size_t> _dropped;
+
+        // producer and consumer counters are kept in separate cache lines
+        char _producerPadding[64];
+        std::atomic<size_t> _head;
+        mutable size_t _cachedTail;
+        char _consumerPadding[64];
+        std::atomic<size_t> _tail;
+    };
+
+    /// \brief Sink interface implementation, which writes single record into byte_ring.
+    ///
+    /// Record is published by \ref commit() or on destruction. If record doesn't fit
+    /// into free space of ring, it's dropped entirely and counted in \ref byte_ring::dropped().
+    class ring_sink
+    {
+    public:
+        typedef char char_t;
+
+        explicit ring_sink(byte_ring &ring)
+            : _ring(ring)
+            , _size(0)
+            , _overflow(false)
+        {}
+
+        ~ring_sink()
+        {
+            commit();
+        }
+
+        void reserve(size_t size)
+        {
+            if (!_ring.fits(size))
+                _overflow = true;
+        }
+
+        void append(const char_t *source, size_t sourceSize)
+        {
+            if (_overflow || !_ring.fits(_size + sourceSize))
+            {
+                _overflow = true;
+                return;
+            }
+            _ring.write(_size, source, sourceSize);
+            _size += sourceSize;
+        }
+
+        size_t size() const { return _size; }
+
+        /// \brief Publish record and start new one.
+        /// \return false if record was dropped
+        bool commit()
+        {
+            bool published = !_overflow;
+            if (_overflow)
+                _ring._dropped.fetch_add(1, std::memory_order_relaxed);
+            else if (_size != 0)
+                _ring.publish(_size);
+            _size = 0;
+            _overflow = false;
+            return published;
+        }
+
+    private:
+        ring_sink(const ring_sink &) = delete;
+        ring_sink &operator=(const ring_sink &) = delete;
+
+        byte_ring &_ring;
+        size_t _size;
+        bool _overflow;
+    };
+}
+
+#endif
@@ -0,0 +1,209 @@
+#include "sharded_sink.h"
+#include <platform/thread_functions.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace strings
+{
+    namespace
+    {
+        /// Header of record in shard buffer, followed by record text
+        struct record_header
+        {
+            uint64_t sequence;
+            uint64_t size;
+        };
+    }
+
+    /// Records of single thread: thread appends to active buffer, merge swaps it with empty spare one
+    struct sharded_sink::shard
+    {
+        std::mutex mutex;
+        std::vector<char> active;
+        std::vector<char> spare;
+    };
+
+    sharded_sink::record::record(sharded_sink &owner)
+        : _owner(owner)
+        , _shard(owner.thread_shard())
+        , _lock(_shard.mutex, std::defer_lock)
+        , _header(0)
+    {
+    }
+
+    sharded_sink::record::~record()
+    {
+        commit();
+    }
+
+    void sharded_sink::record::open()
+    {
+        _lock.lock();
+        _header = _shard.active.size();
+        _shard.active.resize(_header + sizeof(record_header));
+    }
+
+    void sharded_sink::record::reserve(size_t size)
+    {
+        if (!_lock.owns_lock())
+            open();
+        _shard.active.reserve(_header + sizeof(record_header) + size);
+    }
+
+    void sharded_sink::record::append(const char_t *source, size_t sourceSize)
+    {
+        if (!_lock.owns_lock())
+            open();
+        _shard.active.insert(_shard.active.end(), source, source + sourceSize);
+    }
+
+    size_t sharded_sink::record::size() const
+    {
+        return _lock.owns_lock() ? _shard.active.size() - _header - sizeof(record_header) : 0;
+    }
+
+    void sharded_sink::record::commit()
+    {
+        if (!_lock.owns_lock())
+            return;
+
+        record_header header = { 0, uint64_t(size()) };
+        if (header.size == 0)
+        {
+            _shard.active.resize(_header);
+        }
+        else
+        {
+            header.sequence = _owner._sequence.fetch_add(1, std::memory_order_relaxed);
+            memcpy(&_shard.active[_header], &header, sizeof(header));
+        }
+        _lock.unlock();
+    }
+
+    sharded_sink::sharded_sink()
+        : _sequence(0)
+        , _nextSequence(0)
+    {
+        for (size_t i = 0; i < max_shard_chunks; ++i)
+            _chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    sharded_sink::~sharded_sink()
+    {
+        for (size_t i = 0; i < max_shard_chunks; ++i)
+        {
+            std::atomic<shard *> *chunk = _chunks[i].load(std::memory_order_relaxed);
+            if (chunk == nullptr)
+                continue;
+            for (size_t j = 0; j < shard_chunk_size; ++j)
+                delete chunk[j].load(std::memory_order_relaxed);
+            delete[] chunk;
+        }
+    }
+
+    sharded_sink::shard &sharded_sink::thread_shard()
+    {
+        size_t slot = platform::current_thread_slot();
+        if (slot >= shard_chunk_size * max_shard_chunks)
+            throw std::length_error("sharded sink: too many threads");
+
+        std::atomic<shard *> *chunk = _chunks[slot / shard_chunk_size].load(std::memory_order_acquire);
+        if (chunk == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(_chunksMutex);
+            chunk = _chunks[slot / shard_chunk_size].load(std::memory_order_relaxed);
+            if (chunk == nullptr)
+            {
+                chunk = new std::atomic<shard *>[shard_chunk_size];
+                for (size_t i = 0; i < shard_chunk_size; ++i)
+                    chunk[i].store(nullptr, std::memory_order_relaxed);
+                _chunks[slot / shard_chunk_size].store(chunk, std::memory_order_release);
+            }
+        }
+
+        // only owner thread creates its shard
+        shard *result = chunk[slot % shard_chunk_size].load(std::memory_order_relaxed);
+        if (result == nullptr)
+        {
+            result = new shard;
+            chunk[slot % shard_chunk_size].store(result, std::memory_order_release);
+        }
+        return *result;
+    }
+
+    void sharded_sink::read_records(const std::vector<char> &buffer)
+    {
+        const char *data = buffer.data();
+        const char *end = data + buffer.size();
+        while (data != end)
+        {
+            record_header header;
+            memcpy(&header, data, sizeof(header));
+            data += sizeof(header);
+            merged_record merged = { header.sequence, string_view(data, size_t(header.size)) };
+            _records.push_back(merged);
+            data += header.size;
+        }
+    }
+
+    size_t sharded_sink::collect(size_t &total)
+    {
+        _carried.swap(_pending);
+        read_records(_carried);
+        for (size_t i = 0; i < max_shard_chunks; ++i)
+        {
+            std::atomic<shard *> *chunk = _chunks[i].load(std::memory_order_acquire);
+            if (chunk == nullptr)
+                continue;
+            for (size_t j = 0; j < shard_chunk_size; ++j)
+            {
+                shard *current = chunk[j].load(std::memory_order_acquire);
+                if (current == nullptr)
+                    continue;
+                {
+                    std::lock_guard<std::mutex> lock(current->mutex);
+                    current->active.swap(current->spare);
+                }
+                read_records(current->spare);
+            }
+        }
+
+        std::sort(_records.begin(), _records.end(), [](const merged_record &left, const merged_record &right) {
+            return left.sequence < right.sequence;
+        });
+
+        // record with missing sequence number is committed to shard, which is already collected
+        size_t count = 0;
+        while (count < _records.size() && _records[count].sequence == _nextSequence + count)
+            total += _records[count++].text.size();
+        return count;
+    }
+
+    void sharded_sink::release(size_t merged)
+    {
+        _nextSequence += merged;
+        for (size_t i = merged; i < _records.size(); ++i)
+        {
+            record_header header = { _records[i].sequence, uint64_t(_records[i].text.size()) };
+            const char *bytes = reinterpret_cast<const char *>(&header);
+            _pending.insert(_pending.end(), bytes, bytes + sizeof(header));
+            _pending.insert(_pending.end(), _records[i].text.data(), _records[i].text.data() + _records[i].text.size());
+        }
+        _records.clear();
+        _carried.clear();
+
+        for (size_t i = 0; i < max_shard_chunks; ++i)
+        {
+            std::atomic<shard *> *chunk = _chunks[i].load(std::memory_order_acquire);
+            if (chunk == nullptr)
+                continue;
+            for (size_t j = 0; j < shard_chunk_size; ++j)
+            {
+                shard *current = chunk[j].load(std::memory_order_acquire);
+                if (current != nullptr)
+                    current->spare.clear();
+            }
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef __SHARDED_SINK_HEADER_H__
+#define __SHARDED_SINK_HEADER_H__
+
+/// \file
+///
+/// Sink for many producer threads without shared lock.
+///
+/// Each thread writes records into its own shard, records are gathered
+/// into destination sink in order of their completion:
+///
+/// ~~~{.c}
+/// strings::sharded_sink shards;
+///
+/// // any thread
+/// {
+///     strings::sharded_sink::record record(shards);
+///     strings::format_to(record, "{}: {}\n", name, value);
+/// }
+///
+/// // writer thread
+/// shards.merge(file);
+/// ~~~
+
+#include "string_view.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace strings
+{
+    /// \brief Multi-producer sink, which keeps records of each thread in separate shard.
+    ///
+    /// Shards are indexed by dense thread slot (see platform::current_thread_slot()).
+    /// Shard lock is taken only by its thread and by merge, so producers don't contend.
+    class sharded_sink
+    {
+        struct shard;
+
+    public:
+        /// \brief Sink interface implementation for records of current thread.
+        ///
+        /// Record gets sequence number and becomes visible to merge on \ref commit() or destruction,
+        /// shard of thread is locked from first append till commit.
+        /// Thread may write only one record at a time.
+        class record
+        {
+        public:
+            typedef char char_t;
+
+            explicit record(sharded_sink &owner);
+            ~record();
+
+            void reserve(size_t size);
+            void append(const char_t *source, size_t sourceSize);
+            size_t size() const;
+
+            /// \brief Publish record and start new one.
+            void commit();
+
+        private:
+            record(const record &) = delete;
+            record &operator=(const record &) = delete;
+
+            /// Lock shard and write placeholder of record header
+            void open();
+
+            sharded_sink &_owner;
+            shard &_shard;
+            std::unique_lock<std::mutex> _lock;
+            size_t _header;
+        };
+
+        sharded_sink();
+        ~sharded_sink();
+
+        /// \brief Append published records to sink in order of sequence numbers.
+        ///
+        /// Record, which is committed while merge collects shards, may be missed by merge,
+        /// so records after first missing sequence number are kept till next merge.
+        /// If sink throws, records which aren't appended yet are kept till next merge as well.
+        /// \return count of merged records
+        template <class Sink>
+        size_t merge(Sink &sink)
+        {
+            std::lock_guard<std::mutex> lock(_mergeMutex);
+            size_t total = 0;
+            size_t count = collect(total);
+            size_t merged = 0;
+            try
+            {
+                if (total != 0)
+                    sink.reserve(sink.size() + total);
+                for (; merged < count; ++merged)
+                    sink.append(_records[merged].text.data(), _records[merged].text.size());
+            }
+            catch (...)
+            {
+                release(merged);
+                throw;
+            }
+            release(count);
+            return count;
+        }
+
+        /// Count of records published so far
+        uint64_t published() const { return _sequence.load(std::memory_order_relaxed); }
+
+    private:
+        sharded_sink(const sharded_sink &) = delete;
+        sharded_sink &operator=(const sharded_sink &) = delete;
+
+        struct merged_record
+        {
+            uint64_t sequence;
+            string_view text;
+        };
+
+        /// Shard of current thread, created on first use
+        shard &thread_shard();
+
+        /// Add records from buffer of record headers and texts to collected records
+        void read_records(const std::vector<char> &buffer);
+
+        /// \brief Take published records from shards and sort them.
+        /// \param [out] total - total size of records, which are ready for merge
+        /// \return count of records with consecutive sequence numbers, which are ready for merge
+        size_t collect(size_t &total);
+
+        /// Keep records, which aren't merged, till next merge and return collected buffers to shards for reuse
+        void release(size_t merged);
+
+        static const size_t shard_chunk_size = 64;
+        static const size_t max_shard_chunks = 1024;
+
+        std::atomic<std::atomic<shard *> *> _chunks[max_shard_chunks];
+        std::mutex _chunksMutex;
+        std::atomic<uint64_t> _sequence;
+
+        std::mutex _mergeMutex;
+        std::vector<merged_record> _records;
+        uint64_t _nextSequence;             ///< sequence number of next record to merge
+        std::vector<char> _pending;         ///< records waiting for previous sequence numbers
+        std::vector<char> _carried;         ///< pending records, which are collected by current merge
+    };
+}
+
+#endif
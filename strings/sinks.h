@@ -15,6 +15,19 @@
 /// With this interface std::string is sink.
 /// For other data structures we need to implement sink interface explicitly.
 
+#include "formatter.h"
+#include "string_functions.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#endif
+
 namespace strings
 {
 
@@ -47,12 +60,22 @@ namespace strings
 
         void append(const char_t *source, size_t sourceSize)
         {
-            size_t copiedCharacters = string_copy(
-                _buffer + _currentOffset,
-                _bufferSize - _currentOffset,
-                source,
-                sourceSize);
+            if (_currentOffset >= _bufferSize)
+                return;
+            size_t copiedCharacters = std::min(sourceSize, _bufferSize - _currentOffset - 1);
+            memcpy(_buffer + _currentOffset, source, copiedCharacters);
             _currentOffset += copiedCharacters;
+            _buffer[_currentOffset] = '\0';
+        }
+
+        /// \brief Append wide characters converted to UTF-8 directly into buffer.
+        ///
+        /// Conversion stops at first code point which doesn't fit into buffer or is invalid.
+        void append(const wchar_t *source, size_t sourceSize)
+        {
+            if (_currentOffset >= _bufferSize)
+                return;
+            _currentOffset += detail::narrow(_buffer + _currentOffset, _bufferSize - _currentOffset, source, source + sourceSize);
         }
 
         size_t size() const { return _currentOffset; }
@@ -61,6 +84,321 @@ namespace strings
         size_t _bufferSize;
         size_t _currentOffset;
     };
+
+    /// \brief Sink interface implementation for static char buffer, which truncates content instead of throwing.
+    ///
+    /// Buffer always contains null-terminated prefix of appended content,
+    /// truncation is reported by \ref truncated().
+    class truncating_sink
+    {
+    public:
+        typedef char char_t;
+
+        truncating_sink(char_t *buffer, size_t bufferSize)
+            : _buffer(bufferSize != 0 ? buffer : nullptr)
+            , _capacity(bufferSize != 0 ? bufferSize - 1 : 0)
+            , _size(0)
+            , _truncated(false)
+        {
+            if (bufferSize != 0)
+                _buffer[0] = '\0';
+        }
+
+        template <size_t N>
+        explicit truncating_sink(char_t (&buffer)[N])
+            : _buffer(buffer)
+            , _capacity(N - 1)
+            , _size(0)
+            , _truncated(false)
+        {
+            _buffer[0] = '\0';
+        }
+
+        void reserve(size_t) {}
+
+        void append(const char_t *source, size_t sourceSize)
+        {
+            size_t count = sourceSize;
+            if (count > _capacity - _size)
+            {
+                count = _capacity - _size;
+                _truncated = true;
+            }
+            if (count != 0)
+            {
+                memcpy(_buffer + _size, source, count);
+                _size += count;
+                _buffer[_size] = '\0';
+            }
+        }
+
+        /// \brief Append wide characters converted to UTF-8 directly into buffer.
+        void append(const wchar_t *source, size_t sourceSize)
+        {
+            const wchar_t *end = source + sourceSize;
+            size_t available = _capacity - _size;
+            size_t count = detail::narrow(_buffer + _size, available + 1, source, end);
+            // conversion may stop for lack of space only if less than longest code point remains
+            if (available - count < 4 && count < detail::narrow(nullptr, SIZE_MAX, source, end))
+                _truncated = true;
+            _size += count;
+        }
+
+        size_t size() const { return _size; }
+
+        /// Some content didn't fit to buffer
+        bool truncated() const { return _truncated; }
+
+    private:
+        char_t *_buffer;
+        size_t _capacity;
+        size_t _size;
+        bool _truncated;
+    };
+
+    /// \brief Sink, which only counts size of appended content.
+    class counting_sink
+    {
+    public:
+        typedef char char_t;
+
+        counting_sink()
+            : _size(0)
+        {}
+
+        void reserve(size_t) {}
+
+        void append(const char_t *, size_t sourceSize)
+        {
+            _size += sourceSize;
+        }
+
+        size_t size() const { return _size; }
+
+    private:
+        size_t _size;
+    };
+
+    /// Size of local buffer of \ref any_sink
+    const size_t any_sink_buffer_size = 256;
+
+    /// \brief Type-erased reference to any sink.
+    ///
+    /// Allows non-template code (e.g. compiled in .cpp file) to write to any sink.
+    /// Small appends are collected in local buffer and forwarded by single indirect call,
+    /// content is forwarded completely by \ref flush() or on destruction.
+    ///
+    /// ~~~{.c}
+    /// // report.cpp
+    /// void write_report(strings::any_sink &sink, const report &value);
+    ///
+    /// std::string text;
+    /// strings::any_sink sink(text);
+    /// write_report(sink, value);
+    /// ~~~
+    class any_sink
+    {
+    public:
+        typedef char char_t;
+
+        template <class Sink>
+        explicit any_sink(Sink &sink)
+            : _sink(&sink)
+            , _table(&table<Sink>())
+            , _buffered(0)
+        {}
+
+        ~any_sink()
+        {
+            flush();
+        }
+
+        void reserve(size_t size)
+        {
+            _table->reserve(_sink, size);
+        }
+
+        void append(const char_t *source, size_t sourceSize)
+        {
+            if (sourceSize <= any_sink_buffer_size - _buffered)
+            {
+                memcpy(_buffer + _buffered, source, sourceSize);
+                _buffered += sourceSize;
+                return;
+            }
+
+            flush();
+            if (sourceSize >= any_sink_buffer_size)
+            {
+                _table->append(_sink, source, sourceSize);
+                return;
+            }
+            memcpy(_buffer, source, sourceSize);
+            _buffered = sourceSize;
+        }
+
+        size_t size() const { return _table->size(_sink) + _buffered; }
+
+        /// Forward buffered content to sink
+        void flush()
+        {
+            if (_buffered != 0)
+            {
+                _table->append(_sink, _buffer, _buffered);
+                _buffered = 0;
+            }
+        }
+
+    private:
+        any_sink(const any_sink &) = delete;
+        any_sink &operator=(const any_sink &) = delete;
+
+        struct function_table
+        {
+            void (*reserve)(void *sink, size_t size);
+            void (*append)(void *sink, const char_t *source, size_t sourceSize);
+            size_t (*size)(const void *sink);
+        };
+
+        template <class Sink>
+        struct functions
+        {
+            static void reserve(void *sink, size_t size) { static_cast<Sink *>(sink)->reserve(size); }
+            static void append(void *sink, const char_t *source, size_t sourceSize) { static_cast<Sink *>(sink)->append(source, sourceSize); }
+            static size_t size(const void *sink) { return static_cast<const Sink *>(sink)->size(); }
+        };
+
+        template <class Sink>
+        static const function_table &table()
+        {
+            static const function_table result = { &functions<Sink>::reserve, &functions<Sink>::append, &functions<Sink>::size };
+            return result;
+        }
+
+        void *_sink;
+        const function_table *_table;
+        size_t _buffered;
+        char_t _buffer[any_sink_buffer_size];
+    };
+
+    /// \brief Sink, which appends data into list of chunks and never moves written data.
+    ///
+    /// Content is exported as list of chunks without copying, e.g. to iovec array
+    /// for single writev call:
+    ///
+    /// ~~~{.c}
+    /// strings::chunked_sink message;
+    /// strings::format_to(message, "{}: {}\n", header, body);
+    /// std::vector<iovec> vectors(message.chunks_count());
+    /// message.to_iovec(vectors.data(), vectors.size());
+    /// writev(fd, vectors.data(), int(vectors.size()));
+    /// ~~~
+    class chunked_sink
+    {
+    public:
+        typedef char char_t;
+
+        /// \param chunkSize - capacity of allocated chunks (reserve may allocate larger chunk)
+        explicit chunked_sink(size_t chunkSize = 4096)
+            : _chunkSize(std::max<size_t>(chunkSize, 1))
+            , _current(0)
+            , _size(0)
+        {}
+
+        /// \brief Allocate space for total size of content, missing space is allocated as single chunk.
+        void reserve(size_t size)
+        {
+            if (size <= _size)
+                return;
+            size_t available = 0;
+            for (size_t i = _current; i < _chunks.size(); ++i)
+                available += _chunks[i].capacity() - _chunks[i].size();
+            if (available < size - _size)
+                add_chunk(std::max(_chunkSize, size - _size - available));
+        }
+
+        void append(const char_t *source, size_t sourceSize)
+        {
+            _size += sourceSize;
+            while (sourceSize != 0)
+            {
+                if (_current == _chunks.size())
+                    add_chunk(_chunkSize);
+                std::vector<char_t> &chunk = _chunks[_current];
+                size_t count = std::min(sourceSize, chunk.capacity() - chunk.size());
+                chunk.insert(chunk.end(), source, source + count);
+                source += count;
+                sourceSize -= count;
+                if (chunk.size() == chunk.capacity())
+                    ++_current;
+            }
+        }
+
+        size_t size() const { return _size; }
+
+        /// Count of chunks with content
+        size_t chunks_count() const
+        {
+            return _current < _chunks.size() && !_chunks[_current].empty() ? _current + 1 : _current;
+        }
+
+        const char_t *chunk_data(size_t index) const { return _chunks[index].data(); }
+        size_t chunk_size(size_t index) const { return _chunks[index].size(); }
+
+        /// \brief Remove content, allocated chunks are kept for reuse.
+        void clear()
+        {
+            for (size_t i = 0; i < _chunks.size(); ++i)
+                _chunks[i].clear();
+            _current = 0;
+            _size = 0;
+        }
+
+        /// \brief Copy content to buffer.
+        /// \return count of copied characters
+        size_t copy_to(char_t *buffer, size_t bufferSize) const
+        {
+            size_t copied = 0;
+            for (size_t i = 0; i < chunks_count() && copied < bufferSize; ++i)
+            {
+                size_t count = std::min(_chunks[i].size(), bufferSize - copied);
+                memcpy(buffer + copied, _chunks[i].data(), count);
+                copied += count;
+            }
+            return copied;
+        }
+
+#if !defined(_WIN32)
+        /// \brief Fill iovec array with chunks starting from firstChunk.
+        /// \return count of filled elements (less than chunks count if vectorsCount is too small, e.g. IOV_MAX)
+        size_t to_iovec(iovec *vectors, size_t vectorsCount, size_t firstChunk = 0) const
+        {
+            size_t count = std::min(vectorsCount, chunks_count() - std::min(firstChunk, chunks_count()));
+            for (size_t i = 0; i < count; ++i)
+            {
+                const std::vector<char_t> &chunk = _chunks[firstChunk + i];
+                vectors[i].iov_base = const_cast<char_t *>(chunk.data());
+                vectors[i].iov_len = chunk.size();
+            }
+            return count;
+        }
+#endif
+
+    private:
+        chunked_sink(const chunked_sink &) = delete;
+        chunked_sink &operator=(const chunked_sink &) = delete;
+
+        void add_chunk(size_t capacity)
+        {
+            _chunks.push_back(std::vector<char_t>());
+            _chunks.back().reserve(capacity);
+        }
+
+        std::vector<std::vector<char_t> > _chunks;
+        size_t _chunkSize;
+        size_t _current;    ///< chunk, which receives appended data: previous chunks are full, next ones are empty
+        size_t _size;
+    };
 }
 
 #endif
\ No newline at end of file
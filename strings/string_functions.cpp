@@ -1,15 +1,144 @@
 #include "string_functions.h"
+#include "hex_digits.h"
 #include <algorithm>
 #include <array_size.h>
 #include <cstring>
+#include <cwchar>
+#include <type_traits>
 #include <boost/nowide/convert.hpp>
 #include "config.in.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STRINGS_COPY_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 /// \defgroup strings strings
 /// \ingroup common-tools
 ///
 /// This group contains utility classes and functions work with strings.
 
+// single-pass bounded copy
+namespace strings
+{
+    namespace detail
+    {
+#if defined(STRINGS_COPY_SSE2)
+        inline unsigned first_set_bit(unsigned mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return unsigned(index);
+#else
+            return unsigned(__builtin_ctz(mask));
+#endif
+        }
+
+        inline __m128i zero_chars(__m128i block, char) { return _mm_cmpeq_epi8(block, _mm_setzero_si128()); }
+        inline __m128i zero_chars(__m128i block, char16_t) { return _mm_cmpeq_epi16(block, _mm_setzero_si128()); }
+        inline __m128i zero_chars(__m128i block, char32_t) { return _mm_cmpeq_epi32(block, _mm_setzero_si128()); }
+
+        /// Character type with the same size as Char, used to select SSE2 comparison
+        template <class Char>
+        struct lane
+        {
+            typedef typename std::conditional<sizeof(Char) == 1, char,
+                typename std::conditional<sizeof(Char) == 2, char16_t, char32_t>::type>::type type;
+        };
+#endif
+
+        inline const char *find_zero(const char *source, size_t size)
+        {
+            return static_cast<const char *>(memchr(source, 0, size));
+        }
+
+        inline const wchar_t *find_zero(const wchar_t *source, size_t size)
+        {
+            return wmemchr(source, 0, size);
+        }
+
+        /// Characters copied by 16-byte blocks before switching to chunks
+        const size_t short_copy_bytes = 64;
+
+        /// Size of chunk, which is searched for terminating zero and then copied while it's in L1 cache
+        const size_t copy_chunk_bytes = 8192;
+
+        /// \brief Copy at most limit characters of source, stop at terminating zero, then terminate buffer.
+        ///
+        /// Search of terminating zero is fused with copying: short prefix is read once by 16-byte blocks,
+        /// which never cross page boundary, so reading after terminating zero is safe; longer strings are
+        /// searched and copied by chunks, so source is read from memory only once.
+        /// \return count of copied characters
+        template <class Char>
+        size_t copy_terminated(Char *buffer, const Char *source, size_t limit)
+        {
+            size_t count = 0;
+#if defined(STRINGS_COPY_SSE2)
+            const size_t blockChars = 16 / sizeof(Char);
+            const size_t pageSize = 4096;
+            while (limit - count >= blockChars && count < short_copy_bytes / sizeof(Char))
+            {
+                const Char *p = source + count;
+                if (reinterpret_cast<uintptr_t>(p) % pageSize > pageSize - 16)
+                {
+                    // block crosses page boundary, copy characters till it one by one
+                    size_t tillPage = (pageSize - reinterpret_cast<uintptr_t>(p) % pageSize) / sizeof(Char);
+                    for (size_t i = 0; i < tillPage; ++i, ++count)
+                    {
+                        if (source[count] == 0)
+                        {
+                            buffer[count] = 0;
+                            return count;
+                        }
+                        buffer[count] = source[count];
+                    }
+                    continue;
+                }
+
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                unsigned zeros = unsigned(_mm_movemask_epi8(zero_chars(block, typename lane<Char>::type())));
+                if (zeros != 0)
+                {
+                    size_t length = first_set_bit(zeros) / sizeof(Char);
+                    memcpy(buffer + count, p, length * sizeof(Char));
+                    count += length;
+                    buffer[count] = 0;
+                    return count;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer + count), block);
+                count += blockChars;
+            }
+
+            if (limit - count < blockChars)
+            {
+                // less than block is left before limit, don't read after it
+                for (; count < limit && source[count] != 0; ++count)
+                    buffer[count] = source[count];
+                buffer[count] = 0;
+                return count;
+            }
+#endif
+            while (count < limit)
+            {
+                size_t chunk = std::min(limit - count, copy_chunk_bytes / sizeof(Char));
+                const Char *zero = find_zero(source + count, chunk);
+                size_t length = zero != nullptr ? size_t(zero - (source + count)) : chunk;
+                memcpy(buffer + count, source + count, length * sizeof(Char));
+                count += length;
+                if (zero != nullptr)
+                    break;
+            }
+            buffer[count] = 0;
+            return count;
+        }
+    }
+}
+
 /// \ingroup strings
 /// \brief contains functions that works with strings
 namespace strings
@@ -24,11 +153,12 @@ namespace strings
     {
         if (!buffer || !bufferMaxSize)
             return 0;
-        strcpy(buffer, "");
         if (!source)
+        {
+            buffer[0] = '\0';
             return 0;
-        strncat(buffer, source, std::min(bufferMaxSize - 1, sourceSize));
-        return strlen(buffer);
+        }
+        return detail::copy_terminated(buffer, source, std::min(bufferMaxSize - 1, sourceSize));
     }
 
     /// \brief String copy
@@ -40,11 +170,12 @@ namespace strings
     {
         if (!buffer || !bufferMaxSize)
             return 0;
-        strcpy(buffer, "");
         if (!source)
+        {
+            buffer[0] = '\0';
             return 0;
-        strncat(buffer, source, bufferMaxSize-1);
-        return strlen(buffer);
+        }
+        return detail::copy_terminated(buffer, source, bufferMaxSize - 1);
     }
 
     /// \brief String copy with narrowing of source
@@ -127,11 +258,12 @@ namespace strings
     {
         if (!buffer || !bufferMaxSize)
             return 0;
-        wcscpy(buffer, L"");
         if (!source)
+        {
+            buffer[0] = L'\0';
             return 0;
-        wcsncat(buffer, source, std::min(bufferMaxSize - 1, sourceSize));
-        return wcslen(buffer);
+        }
+        return detail::copy_terminated(buffer, source, std::min(bufferMaxSize - 1, sourceSize));
     }
 
     /// \brief String copy
@@ -143,11 +275,12 @@ namespace strings
     {
         if (!buffer || !bufferMaxSize)
             return 0;
-        wcscpy(buffer, L"");
         if (!source)
+        {
+            buffer[0] = L'\0';
             return 0;
-        wcsncat(buffer, source, bufferMaxSize-1);
-        return wcslen(buffer);
+        }
+        return detail::copy_terminated(buffer, source, bufferMaxSize - 1);
     }
 }
 
@@ -156,13 +289,6 @@ namespace strings
 {
     namespace detail
     {
-
-        inline char get_digit(unsigned char byte)
-        {
-            static char temp_table[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-            return temp_table[byte & 0xf];
-        }
-
         template <class char_type>
         size_t buffer_to_string_implementation(char_type *dest, size_t dest_len, const void *void_src, size_t src_len, char_type delimiter)
         {
@@ -328,5 +454,28 @@ namespace strings
 #   endif
 #endif
     }
-}
 
+    /// \brief Length of formatted output conversion.
+    /// \return count of characters (excluding terminating null byte) which
+    ///         str_printf would write to large enough buffer, negative on error.
+    ptrdiff_t str_printf_size(const char *format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        ptrdiff_t result = str_vprintf_size(format, ap);
+        va_end(ap);
+        return result;
+    }
+
+    /// \copydoc str_printf_size
+    ptrdiff_t str_vprintf_size(const char *format, va_list args)
+    {
+#if HAVE_SNPRINTF == 1
+        return ::vsnprintf(nullptr, 0, format, args);
+#else
+#   if defined (_WIN32)
+        return _vscprintf(format, args);
+#   endif
+#endif
+    }
+}
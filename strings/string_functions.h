@@ -1,3 +1,6 @@
+#ifndef __STRING_FUNCTIONS_HEADER_H__
+#define __STRING_FUNCTIONS_HEADER_H__
+
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
@@ -27,4 +30,8 @@ namespace strings
 {
     ptrdiff_t str_printf(char *dest, size_t dest_len, const char *format, ...);
     ptrdiff_t str_vprintf(char *dest, size_t dest_len, const char *format, va_list args);
+    ptrdiff_t str_printf_size(const char *format, ...);
+    ptrdiff_t str_vprintf_size(const char *format, va_list args);
 }
+
+#endif
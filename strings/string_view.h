@@ -0,0 +1,57 @@
+#ifndef __STRING_VIEW_HEADER_H__
+#define __STRING_VIEW_HEADER_H__
+
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+#include <string>
+
+namespace strings
+{
+    /// \brief Non-owning reference to characters with known length.
+    ///
+    /// Characters are not required to be null-terminated.
+    template <class Char>
+    class basic_string_view
+    {
+    public:
+        typedef Char char_t;
+
+        basic_string_view()
+            : _data(nullptr)
+            , _size(0)
+        {}
+
+        basic_string_view(const char_t *data, size_t size)
+            : _data(data)
+            , _size(size)
+        {}
+
+        basic_string_view(const char_t *data)
+            : _data(data)
+            , _size(data != nullptr ? length(data) : 0)
+        {}
+
+        template <class Traits, class Alloc>
+        basic_string_view(const std::basic_string<char_t, Traits, Alloc> &value)
+            : _data(value.data())
+            , _size(value.size())
+        {}
+
+        const char_t *data() const { return _data; }
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+    private:
+        static size_t length(const char *data) { return strlen(data); }
+        static size_t length(const wchar_t *data) { return wcslen(data); }
+
+        const char_t *_data;
+        size_t _size;
+    };
+
+    typedef basic_string_view<char> string_view;
+    typedef basic_string_view<wchar_t> wstring_view;
+}
+
+#endif
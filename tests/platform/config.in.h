@@ -0,0 +1,6 @@
+#define TEST_COMMON_FILENAME "test-common-tools"
+#define TEST_COMMON_LOCATION "/tmp/b/tests/test-common-tools"
+#define TEST_COMMON_DIRECTORY "/tmp/b/tests"
+#define CMAKE_SOURCE_DIR "/root/repo"
+#define CMAKE_CURENT_SOURCE_DIRECTORY "/root/repo/tests"
+#define CMAKE_CURRENT_BINARY_DIR "/tmp/b/tests"
@@ -1,5 +1,7 @@
 #include <catch/catch.hpp>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <platform/thread_functions.h>
 #include <thread>
 
@@ -16,3 +18,40 @@ TEST_CASE("get_current_thread_id", "[thread][platform]")
 
     REQUIRE(childTid != tid);
 }
+
+TEST_CASE("current_thread_slot", "[thread][platform]")
+{
+    size_t slot = platform::current_thread_slot();
+    CHECK(platform::current_thread_slot() == slot);
+
+    size_t childSlots[2] = {};
+    std::thread first([&childSlots]() { childSlots[0] = platform::current_thread_slot(); });
+    first.join();
+    std::thread second([&childSlots]() { childSlots[1] = platform::current_thread_slot(); });
+    second.join();
+
+    CHECK(childSlots[0] != slot);
+    CHECK(childSlots[1] != slot);
+    // slot of exited thread is reused
+    CHECK(childSlots[1] == childSlots[0]);
+
+    size_t runningSlots[2] = {};
+    std::mutex mutex;
+    std::condition_variable started;
+    size_t startedCount = 0;
+    auto body = [&](size_t index) {
+        runningSlots[index] = platform::current_thread_slot();
+        std::unique_lock<std::mutex> lock(mutex);
+        ++startedCount;
+        started.notify_all();
+        started.wait(lock, [&]() { return startedCount == 2; });
+    };
+    std::thread third(body, 0);
+    std::thread fourth(body, 1);
+    third.join();
+    fourth.join();
+
+    CHECK(runningSlots[0] != slot);
+    CHECK(runningSlots[1] != slot);
+    REQUIRE(runningSlots[0] != runningSlots[1]);
+}
@@ -0,0 +1,96 @@
+﻿#include <catch/catch.hpp>
+#include <strings/checked_format.h>
+#include <strings/sinks.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("compiled pattern tests", "[format]") {
+    SECTION("output matches runtime pattern") {
+        strings::compiled_pattern pattern("{}: {} ({:x}) {{{:>6.2f}}}");
+        CHECK(pattern.arguments() == 4);
+        CHECK(strings::format(pattern, "value", 42, 42, 3.14159) == strings::format("{}: {} ({:x}) {{{:>6.2f}}}", "value", 42, 42, 3.14159));
+        REQUIRE(strings::format(pattern, "value", 42, 42, 3.14159) == "value: 42 (2a) {  3.14}");
+    }
+
+    SECTION("explicit argument indexes") {
+        strings::compiled_pattern pattern("{1}-{0}-{1}");
+        CHECK(pattern.arguments() == 2);
+        REQUIRE(strings::format(pattern, "a", "b") == "b-a-b");
+    }
+
+    SECTION("pattern without fields") {
+        strings::compiled_pattern pattern("plain text");
+        CHECK(pattern.arguments() == 0);
+        REQUIRE(strings::format(pattern) == "plain text");
+    }
+
+    SECTION("pattern is reused") {
+        strings::compiled_pattern pattern("[{:5}]");
+        std::string text;
+        for (int i = 0; i < 3; ++i)
+            strings::format_to(text, pattern, i);
+        REQUIRE(text == "[    0][    1][    2]");
+    }
+
+    SECTION("small sink is reserved") {
+        char buffer[8];
+        strings::static_array_sink sink(buffer, sizeof(buffer));
+        strings::compiled_pattern pattern("{}{}");
+        size_t result = strings::format_to(sink, pattern, "abcd", 123456);
+        CHECK(result == 7);
+        REQUIRE(std::string(buffer) == "abcd123");
+    }
+
+    SECTION("malformed pattern throws") {
+        REQUIRE_THROWS_AS(strings::compiled_pattern("{:q}"), const std::invalid_argument &);
+    }
+
+    SECTION("missing argument throws") {
+        strings::compiled_pattern pattern("{} {}");
+        std::string text;
+        REQUIRE_THROWS_AS(strings::format_to(text, pattern, 1), const std::invalid_argument &);
+    }
+}
+
+TEST_CASE("checked format tests", "[format]") {
+    SECTION("format to sink") {
+        std::string text;
+        size_t result = STRINGS_FORMAT_TO(text, "{}: {} ({:x})", "value", 42, 42);
+        CHECK(result == 14);
+        REQUIRE(text == "value: 42 (2a)");
+    }
+
+    SECTION("format to string") {
+        std::string name = "ratio";
+        REQUIRE(STRINGS_FORMAT("{}={:.3f} {:c}{:s}", name, 0.5, 'x', true) == "ratio=0.500 xtrue");
+    }
+
+    SECTION("call site is formatted with its arguments each time") {
+        std::string text;
+        for (int i = 0; i < 3; ++i)
+            STRINGS_FORMAT_TO(text, "{0}{0}", i);
+        REQUIRE(text == "001122");
+    }
+
+#if defined(STRINGS_CHECKED_PATTERNS)
+    SECTION("patterns are checked at compile time") {
+        using strings::detail::check_pattern;
+        using strings::detail::pattern_arguments;
+        typedef pattern_arguments<int, double, const char *> arguments;
+
+        static_assert(check_pattern("{} {:.2f} {:s}", arguments()) == strings::detail::pattern_valid, "valid pattern");
+        static_assert(check_pattern("{{}} {2} {0:#x} {1:<+10e}", arguments()) == strings::detail::pattern_valid, "indexes and escapes");
+        static_assert(check_pattern("{:*^8lld}", arguments()) == strings::detail::pattern_valid, "fill, alignment and length");
+        static_assert(check_pattern("{", arguments()) == strings::detail::pattern_malformed, "unclosed field");
+        static_assert(check_pattern("}", arguments()) == strings::detail::pattern_malformed, "unmatched brace");
+        static_assert(check_pattern("{:q}", arguments()) == strings::detail::pattern_malformed, "unknown type");
+        static_assert(check_pattern("{3}", arguments()) == strings::detail::pattern_missing_argument, "missing argument");
+        static_assert(check_pattern("{}{}{}{}", arguments()) == strings::detail::pattern_missing_argument, "missing argument");
+        static_assert(check_pattern("{:f}", arguments()) == strings::detail::pattern_type_mismatch, "integer as floating point");
+        static_assert(check_pattern("{1:d}", arguments()) == strings::detail::pattern_type_mismatch, "floating point as integer");
+        static_assert(check_pattern("{2:x}", arguments()) == strings::detail::pattern_type_mismatch, "string as integer");
+        SUCCEED();
+    }
+#endif
+}
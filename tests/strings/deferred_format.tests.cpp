@@ -0,0 +1,153 @@
+﻿#include <catch/catch.hpp>
+#include <strings/deferred_format.h>
+#include <strings/sinks.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct order_id
+    {
+        uint32_t value;
+    };
+}
+
+namespace strings
+{
+    template <>
+    struct formatter_traits<order_id>
+    {
+        template <class Sink>
+        static void format(Sink &sink, const order_id &id, const format_spec &)
+        {
+            char text[16];
+            size_t length = str_printf(text, sizeof(text), "#%u", unsigned(id.value));
+            sink.append(text, length);
+        }
+    };
+}
+
+TEST_CASE("deferred format tests", "[format][deferred]") {
+    static const strings::pattern_id valuesPattern = strings::register_pattern("{}: {} ({:x}) {:.2f} {}");
+    static const strings::pattern_id stringsPattern = strings::register_pattern("[{}|{}|{}|{}]");
+    static const strings::pattern_id orderPattern = strings::register_pattern("order {} at {}");
+
+    SECTION("registered patterns") {
+        CHECK(std::string(strings::registered_pattern(orderPattern)) == "order {} at {}");
+        REQUIRE_THROWS_AS(strings::registered_pattern(strings::pattern_id(-2)), const std::out_of_range &);
+    }
+
+    SECTION("values are rendered as by format") {
+        strings::deferred_buffer buffer;
+        REQUIRE(buffer.capture(valuesPattern, "value", 42, 42u, 3.14159, true));
+
+        std::string text;
+        REQUIRE(buffer.render(text));
+        CHECK(text == strings::format("{}: {} ({:x}) {:.2f} {}", "value", 42, 42u, 3.14159, true));
+        REQUIRE_FALSE(buffer.render(text));
+    }
+
+    SECTION("strings are copied on capture") {
+        strings::deferred_buffer buffer;
+        {
+            char mutableText[] = "array";
+            std::string text = "std::string";
+            std::wstring wide = L"wide";
+            const char *pointer = text.c_str();
+            REQUIRE(buffer.capture(stringsPattern, mutableText, text, wide, pointer));
+            mutableText[0] = 'X';
+            text.assign(text.size(), 'X');
+            wide.assign(wide.size(), L'X');
+        }
+
+        std::string text;
+        REQUIRE(buffer.render(text));
+        REQUIRE(text == "[array|std::string|wide|std::string]");
+    }
+
+    SECTION("user types and timestamps") {
+        strings::deferred_buffer buffer;
+        order_id id = { 42 };
+        strings::timestamp time = { 0, strings::timestamp::seconds, strings::timestamp::utc };
+        REQUIRE(buffer.capture(orderPattern, id, time));
+
+        std::string text;
+        REQUIRE(buffer.render(text));
+        REQUIRE(text == "order #42 at 1970-01-01T00:00:00Z");
+    }
+
+    SECTION("messages are dropped when buffer is full and ring wraps around") {
+        strings::deferred_buffer buffer(256);
+        CHECK(buffer.capacity() == 256);
+
+        size_t captured = 0;
+        while (buffer.capture(orderPattern, 1, "xxxxxxxxxxxxxxxx"))
+            ++captured;
+        CHECK(captured > 0);
+        CHECK(buffer.dropped() == 1);
+
+        for (size_t round = 0; round < 100; ++round)
+        {
+            std::string text;
+            REQUIRE(buffer.render(text));
+            REQUIRE(text == "order 1 at xxxxxxxxxxxxxxxx");
+            REQUIRE(buffer.capture(orderPattern, 1, "xxxxxxxxxxxxxxxx"));
+        }
+
+        std::string text;
+        while (buffer.render(text))
+            --captured;
+        CHECK(captured == 0);
+    }
+
+    SECTION("too large message is dropped") {
+        strings::deferred_buffer buffer(64);
+        REQUIRE_FALSE(buffer.capture(orderPattern, 1, std::string(100, 'x')));
+        CHECK(buffer.dropped() == 1);
+    }
+
+    SECTION("thread captures to several formatters") {
+        strings::deferred_formatter first(1024), second(1024);
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(first.capture(orderPattern, 1, i));
+            REQUIRE(second.capture(orderPattern, 2, i));
+        }
+        std::thread other([&first]() { first.capture(orderPattern, 3, 0); });
+        other.join();
+
+        std::string firstText, secondText;
+        CHECK(first.render(firstText) == 4);
+        CHECK(second.render(secondText) == 3);
+        CHECK(firstText.find("order 1 at 0\norder 1 at 1\norder 1 at 2\n") != std::string::npos);
+        CHECK(firstText.find("order 3 at 0\n") != std::string::npos);
+        REQUIRE(secondText == "order 2 at 0\norder 2 at 1\norder 2 at 2\n");
+    }
+
+    SECTION("producer threads") {
+        const size_t threadsCount = 4;
+        const size_t messagesCount = 1000;
+        strings::deferred_formatter formatter(64 * 1024);
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadsCount; ++i)
+        {
+            threads.push_back(std::thread([&formatter, i]() {
+                for (size_t j = 0; j < messagesCount; ++j)
+                    formatter.capture(orderPattern, i, j);
+            }));
+        }
+        for (size_t i = 0; i < threads.size(); ++i)
+            threads[i].join();
+
+        std::string text;
+        size_t rendered = formatter.render(text);
+        size_t captured = rendered + formatter.dropped();
+        CHECK(captured == threadsCount * messagesCount);
+        CHECK(std::count(text.begin(), text.end(), '\n') == ptrdiff_t(rendered));
+        REQUIRE(text.find("order 0 at 0\norder 0 at 1\n") != std::string::npos);
+    }
+}
@@ -0,0 +1,115 @@
+﻿#include <catch/catch.hpp>
+#include <strings/escape_format.h>
+#include <strings/format.h>
+#include <strings/sinks.h>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    /// Byte by byte JSON escaping for comparison
+    std::string reference_json(const std::string &value)
+    {
+        std::string result;
+        for (char c : value)
+        {
+            char text[8];
+            switch (c)
+            {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\b': result += "\\b"; break;
+            case '\f': result += "\\f"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    snprintf(text, sizeof(text), "\\u%04x", unsigned(c));
+                    result += text;
+                }
+                else
+                    result += c;
+            }
+        }
+        return result;
+    }
+
+    std::string escape(const std::string &value, strings::escape_style style)
+    {
+        std::string result;
+        strings::append_escaped(result, value, style);
+        return result;
+    }
+}
+
+TEST_CASE("escape formatter tests", "[formatter][escape]") {
+    char buffer[256]{};
+
+    SECTION("json escaping") {
+        CHECK(escape("plain text", strings::escape_json) == "plain text");
+        CHECK(escape("", strings::escape_json) == "");
+        CHECK(escape("say \"hi\"\\n", strings::escape_json) == "say \\\"hi\\\"\\\\n");
+        CHECK(escape("line\nnext\ttab\x01\x1f", strings::escape_json) == "line\\nnext\\ttab\\u0001\\u001f");
+        REQUIRE(escape("\xd0\xbf\xd1\x80\xd0\xb8/\x7f", strings::escape_json) == "\xd0\xbf\xd1\x80\xd0\xb8/\x7f");
+    }
+
+    SECTION("special characters at every position of vector chunks") {
+        const char specials[] = { '"', '\\', '\n', '\x01', '\x1f', '\0' };
+        for (size_t length = 1; length < 80; ++length) {
+            for (size_t position = 0; position < length; ++position) {
+                for (char special : specials) {
+                    std::string value(length, 'a');
+                    value[position] = special;
+                    value[length - 1 - position] = char(0xC0);
+                    INFO(length << " " << position << " " << int(special));
+                    REQUIRE(escape(value, strings::escape_json) == reference_json(value));
+                }
+            }
+        }
+    }
+
+    SECTION("c literal escaping") {
+        CHECK(escape("plain", strings::escape_c) == "plain");
+        CHECK(escape("a\"b\\c", strings::escape_c) == "a\\\"b\\\\c");
+        CHECK(escape("\a\b\f\n\r\t\v", strings::escape_c) == "\\a\\b\\f\\n\\r\\t\\v");
+        CHECK(escape(std::string("\0" "1\x7f", 3), strings::escape_c) == "\\0001\\177");
+        REQUIRE(escape("\x1b[0m", strings::escape_c) == "\\033[0m");
+    }
+
+    SECTION("csv quoting") {
+        CHECK(escape("plain field", strings::escape_csv) == "plain field");
+        CHECK(escape("a,b", strings::escape_csv) == "\"a,b\"");
+        CHECK(escape("say \"hi\"", strings::escape_csv) == "\"say \"\"hi\"\"\"");
+        CHECK(escape("\"", strings::escape_csv) == "\"\"\"\"");
+        CHECK(escape("two\nlines", strings::escape_csv) == "\"two\nlines\"");
+        REQUIRE(escape(std::string(40, 'x') + ",", strings::escape_csv) == "\"" + std::string(40, 'x') + ",\"");
+    }
+
+    SECTION("formatter of escaped string") {
+        std::string value = "tab\there \"quoted\"";
+        strings::formatter formatter = strings::get_formatter(strings::json_escaped(value));
+        size_t result = formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 20);
+        CHECK(std::string(buffer) == "tab\\there \\\"quoted\\\"");
+        CHECK(formatter.size() == result);
+
+        strings::format_spec spec = strings::default_format_spec();
+        spec.width = 10;
+        spec.alignment = strings::format_spec::align_left;
+        strings::get_formatter(strings::c_escaped("a\nb")).format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(std::string(buffer) == "a\\nb      ");
+
+        result = formatter.format(buffer, 6);
+        CHECK(result == 5);
+        REQUIRE(std::string(buffer) == "tab\\t");
+    }
+
+    SECTION("escaped strings in format pattern") {
+        std::string name = "O'Neil \"Jr\"";
+        CHECK(strings::format("{{\"user\":\"{}\"}}", strings::json_escaped(name)) == "{\"user\":\"O'Neil \\\"Jr\\\"\"}");
+        CHECK(strings::format("{},{},{}", strings::csv_quoted("id"), strings::csv_quoted("a,b"), 42) == "id,\"a,b\",42");
+        REQUIRE(strings::formatted_size("{}", strings::json_escaped(std::string(100, '\n'))) == 200);
+    }
+}
@@ -0,0 +1,131 @@
+﻿#include <catch/catch.hpp>
+#include <strings/file_sink.h>
+#include <strings/format.h>
+#include <string>
+
+#if defined(PLATFORM_LINUX)
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    /// Pipe with non-blocking read end
+    struct test_pipe
+    {
+        test_pipe()
+        {
+            int descriptors[2];
+            REQUIRE(pipe(descriptors) == 0);
+            fcntl(descriptors[0], F_SETFL, O_NONBLOCK);
+            input.reset(descriptors[0]);
+            output.reset(descriptors[1]);
+        }
+
+        std::string read_all()
+        {
+            std::string result;
+            char buffer[4096];
+            ssize_t count;
+            while ((count = ::read(input.get(), buffer, sizeof(buffer))) > 0)
+                result.append(buffer, size_t(count));
+            return result;
+        }
+
+        KennyKerr::file_descriptor input;
+        KennyKerr::file_descriptor output;
+    };
+}
+
+TEST_CASE("file sink tests", "[sinks]") {
+    test_pipe pipe;
+
+    SECTION("explicit flush") {
+        strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_explicit);
+        strings::format_to(sink, "{}: {}\n", "value", 42);
+        CHECK(sink.size() == 10);
+        CHECK(pipe.read_all() == "");
+        CHECK(sink.flush());
+        REQUIRE(pipe.read_all() == "value: 42\n");
+    }
+
+    SECTION("flush on newline") {
+        strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_on_newline);
+        sink.append("abc", 3);
+        CHECK(pipe.read_all() == "");
+        sink.append("d\nef", 4);
+        CHECK(pipe.read_all() == "abcd\nef");
+        sink.append("g", 1);
+        REQUIRE(pipe.read_all() == "");
+    }
+
+    SECTION("flush on size") {
+        strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_on_size, 16, 4);
+        sink.append("ab", 2);
+        CHECK(pipe.read_all() == "");
+        sink.append("cde", 3);
+        CHECK(pipe.read_all() == "abcde");
+        sink.append("f", 1);
+        REQUIRE(pipe.read_all() == "");
+    }
+
+    SECTION("full buffer is written") {
+        strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_explicit, 8);
+        sink.append("01234", 5);
+        CHECK(pipe.read_all() == "");
+        sink.append("567", 3);
+        CHECK(pipe.read_all() == "01234567");
+        sink.append("89a", 3);
+        sink.append("bcdef", 5);
+        CHECK(pipe.read_all() == "89abcdef");
+        sink.append("ghijkl", 6);
+        sink.append("mno", 3);
+        CHECK(pipe.read_all() == "ghijklmn");
+        CHECK(sink.size() == 25);
+        CHECK(sink.flush());
+        REQUIRE(pipe.read_all() == "o");
+    }
+
+    SECTION("large content is written with buffered content") {
+        strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_explicit, 8);
+        sink.append("ab", 2);
+        std::string large(100, 'x');
+        sink.append(large.data(), large.size());
+        CHECK(sink.size() == 102);
+        REQUIRE(pipe.read_all() == "ab" + large);
+    }
+
+    SECTION("content is flushed on destruction") {
+        {
+            strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_explicit);
+            sink.append("tail", 4);
+        }
+        REQUIRE(pipe.read_all() == "tail");
+    }
+
+    SECTION("write error is recorded") {
+        strings::file_sink sink(KennyKerr::file_descriptor(open("/dev/null", O_RDONLY)), strings::file_sink::flush_explicit);
+        sink.append("abc", 3);
+        CHECK(sink.error() == 0);
+        CHECK_FALSE(sink.flush());
+        CHECK(sink.error() == EBADF);
+        sink.append("def", 3);
+        REQUIRE_FALSE(sink.flush());
+    }
+
+    SECTION("full non-blocking descriptor is write error") {
+        fcntl(pipe.output.get(), F_SETFL, O_NONBLOCK);
+        strings::file_sink sink(std::move(pipe.output), strings::file_sink::flush_explicit, 1024);
+        std::string large(1024 * 1024, 'x');
+        sink.append(large.data(), large.size());
+        CHECK(sink.error() == EAGAIN);
+        sink.append("abc", 3);
+        CHECK_FALSE(sink.flush());
+        std::string written = pipe.read_all();
+        CHECK(written.size() < large.size());
+        REQUIRE(written == large.substr(0, written.size()));
+    }
+}
+
+#endif
@@ -0,0 +1,417 @@
+﻿#include <catch/catch.hpp>
+#include <strings/format.h>
+#include <strings/sinks.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("format pattern tests", "[format]") {
+    SECTION("sequential arguments") {
+        std::string text;
+        size_t result = strings::format_to(text, "{}: {} ({:x})", "value", 42, 42);
+        CHECK(result == 14);
+        REQUIRE(text == "value: 42 (2a)");
+    }
+
+    SECTION("appends to existing sink content") {
+        std::string text = "> ";
+        size_t result = strings::format_to(text, "{}", 12345u);
+        CHECK(result == 5);
+        REQUIRE(text == "> 12345");
+    }
+
+    SECTION("pattern without arguments") {
+        REQUIRE(strings::format("plain text") == "plain text");
+        REQUIRE(strings::format("") == "");
+    }
+
+    SECTION("escaped braces") {
+        REQUIRE(strings::format("{{}}") == "{}");
+        REQUIRE(strings::format("{{{}}}", 1) == "{1}");
+        REQUIRE(strings::format("a{{b}}c") == "a{b}c");
+    }
+
+    SECTION("explicit argument indexes") {
+        REQUIRE(strings::format("{1} {0} {1}", "a", "b") == "b a b");
+        REQUIRE(strings::format("{1} {}", 1, 2, 3) == "2 3");
+    }
+
+    SECTION("pointers above 4 GiB in hexadecimal") {
+        if (sizeof(void *) < sizeof(uint64_t))
+            return;
+        void *pointer = reinterpret_cast<void *>(uintptr_t(0x123456789abcULL));
+        std::string text;
+        strings::format_to(text, "{:x} {:X}", pointer, pointer);
+        REQUIRE(text == "123456789abc 123456789ABC");
+    }
+
+    SECTION("format specifications") {
+        REQUIRE(strings::format("[{:5}]", 42) == "[   42]");
+        REQUIRE(strings::format("[{:-5}]", 42) == "[42   ]");
+        REQUIRE(strings::format("[{:08X}]", 0xBEEFu) == "[0000BEEF]");
+        REQUIRE(strings::format("[{:#o}]", 8) == "[010]");
+        REQUIRE(strings::format("[{:+d}]", 7) == "[+7]");
+        REQUIRE(strings::format("[{:.3f}]", 3.14159) == "[3.142]");
+        REQUIRE(strings::format("[{:e}]", 1500.0) == "[1.500000e+03]");
+        REQUIRE(strings::format("[{:.2s}]", "abc") == "[ab]");
+        REQUIRE(strings::format("[{0:x}|{0:d}]", 255) == "[ff|255]");
+    }
+
+    SECTION("alignment and fill") {
+        REQUIRE(strings::format("[{:<6}]", 42) == "[42    ]");
+        REQUIRE(strings::format("[{:>6}]", "ab") == "[    ab]");
+        REQUIRE(strings::format("[{:^6}]", "ab") == "[  ab  ]");
+        REQUIRE(strings::format("[{:^7}]", "ab") == "[  ab   ]");
+        REQUIRE(strings::format("[{:*^9.2f}]", 3.14159) == "[**3.14***]");
+        REQUIRE(strings::format("[{:.>8x}]", 255) == "[......ff]");
+        REQUIRE(strings::format("[{:_<8}]", true) == "[true____]");
+        REQUIRE(strings::format("[{:>06}]", -42) == "[-00042]");
+        REQUIRE(strings::format("[{:^06}]", -42) == "[ -42  ]");
+        REQUIRE(strings::format("[{:^^5}]", 'c') == "[^^c^^]");
+        REQUIRE(strings::format("[{:<<5.3}]", "truncated") == "[tru<<]");
+    }
+
+    SECTION("status table columns") {
+        std::string table;
+        strings::format_to(table, "{:<8}|{:>6}|{:^9}\n", "name", "count", "state");
+        strings::format_to(table, "{:<8.8}|{:>6}|{:^9}\n", "receiver-thread", 1234, "running");
+        strings::format_to(table, "{:<8.8}|{:>6}|{:^9}\n", L"sender", -7, "idle");
+        REQUIRE(table ==
+            "name    | count|  state  \n"
+            "receiver|  1234| running \n"
+            "sender  |    -7|  idle   \n");
+    }
+
+    SECTION("integers are formatted as whole values") {
+        REQUIRE(strings::format("{:x}", uint64_t(0x123456789ABCDEFull)) == "123456789abcdef");
+        REQUIRE(strings::format("{}", INT64_MIN) == "-9223372036854775808");
+        REQUIRE(strings::format("{:hhx}", 0x1234) == "34");
+    }
+
+    SECTION("argument types") {
+        std::string str = "string";
+        std::wstring wstr = L"wide";
+        REQUIRE(strings::format("{} {} {} {} {}", str, wstr, 'c', true, 0.1) == "string wide c true 0.1");
+    }
+
+    SECTION("fields longer than stack buffer") {
+        std::string longText(1000, 'x');
+        REQUIRE(strings::format("[{}]", longText) == "[" + longText + "]");
+        REQUIRE(strings::format("{:300d}", 1) == std::string(299, ' ') + "1");
+        REQUIRE(strings::format("{:255d}", 1).size() == 255);
+    }
+
+    SECTION("static array sink") {
+        char buffer[16]{};
+        strings::static_array_sink sink(buffer, sizeof(buffer));
+        strings::format_to(sink, "{}-{}", 1, 2);
+        CHECK(sink.size() == 3);
+        REQUIRE(std::string(buffer) == "1-2");
+    }
+
+    SECTION("malformed patterns") {
+        REQUIRE_THROWS_AS(strings::format("{"), const std::invalid_argument &);
+        REQUIRE_THROWS_AS(strings::format("{", 1), const std::invalid_argument &);
+        REQUIRE_THROWS_AS(strings::format("}", 1), const std::invalid_argument &);
+        REQUIRE_THROWS_AS(strings::format("{x}", 1), const std::invalid_argument &);
+        REQUIRE_THROWS_AS(strings::format("{:q}", 1), const std::invalid_argument &);
+        REQUIRE_THROWS_AS(strings::format("{} {}", 1), const std::invalid_argument &);
+        REQUIRE_THROWS_AS(strings::format("{3}", 1, 2), const std::invalid_argument &);
+    }
+}
+
+namespace
+{
+    /// std::string sink, which counts reserve calls
+    struct reserve_counting_sink
+    {
+        std::string text;
+        size_t reserveCalls = 0;
+        size_t reserved = 0;
+
+        void reserve(size_t size) { ++reserveCalls; reserved = size; text.reserve(size); }
+        void append(const char *source, size_t sourceSize) { text.append(source, sourceSize); }
+        size_t size() const { return text.size(); }
+    };
+}
+
+TEST_CASE("format array tests", "[format]") {
+    SECTION("integers are formatted like single values") {
+        std::vector<uint64_t> values;
+        for (uint64_t power = 1; power != 0 && power <= UINT64_MAX / 10; power *= 10) {
+            values.push_back(power - 1);
+            values.push_back(power);
+            values.push_back(power * 10 - 1);
+            values.push_back(power * 3 + 7);
+        }
+        values.push_back(UINT64_MAX);
+        values.push_back(10000000000000000000ull);
+        uint64_t bits = 0x9E3779B97F4A7C15ull;
+        for (int i = 0; i < 10000; ++i) {
+            bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+            values.push_back(bits >> (i % 64));
+        }
+
+        std::string expected;
+        for (size_t i = 0; i < values.size(); ++i)
+            expected += (i != 0 ? "," : "") + strings::format("{}", values[i]);
+
+        std::string text;
+        size_t result = strings::format_array_to(text, values.data(), values.size(), ",");
+        CHECK(result == expected.size());
+        REQUIRE(text == expected);
+    }
+
+    SECTION("signed and small integer types") {
+        const int64_t values[] = { 0, -1, 1, INT64_MIN, INT64_MAX, -123456789012LL };
+        std::string text;
+        strings::format_array_to(text, values, sizeof(values) / sizeof(values[0]));
+        CHECK(text == "0, -1, 1, -9223372036854775808, 9223372036854775807, -123456789012");
+
+        const int8_t bytes[] = { -128, 0, 127 };
+        text.clear();
+        strings::format_array_to(text, bytes, 3, " ");
+        CHECK(text == "-128 0 127");
+
+        const unsigned short shorts[] = { 65535, 1 };
+        text.clear();
+        strings::format_array_to(text, shorts, 2, "");
+        REQUIRE(text == "655351");
+    }
+
+    SECTION("specification is applied to each value") {
+        const uint32_t values[] = { 1, 255, 4096 };
+        strings::format_spec spec;
+        strings::parse_format_spec("#06x", "#06x" + 4, spec);
+        std::string text;
+        strings::format_array_to(text, values, 3, "|", spec);
+        CHECK(text == "0x0001|0x00ff|0x1000");
+
+        const double doubles[] = { 0.1, -2.5, 1e300, 3.0 };
+        text.clear();
+        strings::format_array_to(text, doubles, 4);
+        CHECK(text == "0.1, -2.5, 1e+300, 3");
+
+        strings::parse_format_spec(">8.2f", ">8.2f" + 5, spec);
+        text.clear();
+        strings::format_array_to(text, doubles, 2, ";", spec);
+        CHECK(text == "    0.10;   -2.50");
+
+        const float floats[] = { 0.1f, 16777216.0f };
+        text.clear();
+        strings::format_array_to(text, floats, 2);
+        REQUIRE(text == "0.1, 16777216");
+    }
+
+    SECTION("large arrays are written in chunks") {
+        std::vector<int> values(10000);
+        std::string expected;
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = int(i * 7919) - 40000;
+            expected += (i != 0 ? ", " : "") + strings::format("{}", values[i]);
+        }
+        std::string text = "values: ";
+        size_t result = strings::format_array_to(text, values.data(), values.size());
+        CHECK(result == expected.size());
+        REQUIRE(text == "values: " + expected);
+    }
+
+    SECTION("values wider than chunk") {
+        const double values[] = { 1.0, 2.0 };
+        strings::format_spec spec = strings::default_format_spec();
+        spec.width = 5000;
+        std::string text;
+        size_t result = strings::format_array_to(text, values, 2, ",", spec);
+        CHECK(result == 10001);
+        CHECK(text.substr(4995, 7) == "    1, ");
+        REQUIRE(text.substr(10000 - 3) == "   2");
+    }
+
+    SECTION("fixed notation of large value at chunk boundary") {
+        std::vector<double> values(444, 1.0);
+        values.push_back(1e300);
+        values.push_back(3.0);
+        strings::format_spec spec;
+        strings::parse_format_spec("f", "f" + 1, spec);
+        std::string expected;
+        for (size_t i = 0; i < values.size(); ++i)
+            expected += (i != 0 ? "," : "") + strings::format("{:f}", values[i]);
+        std::string text;
+        size_t result = strings::format_array_to(text, values.data(), values.size(), ",", spec);
+        CHECK(result == expected.size());
+        REQUIRE(text == expected);
+    }
+
+    SECTION("empty array") {
+        std::string text;
+        REQUIRE(strings::format_array_to(text, static_cast<const int *>(nullptr), 0) == 0);
+        REQUIRE(text.empty());
+    }
+}
+
+TEST_CASE("formatted size tests", "[format]") {
+    SECTION("formatted_size matches format output") {
+        std::string longText(700, 'y');
+        CHECK(strings::formatted_size("") == 0);
+        CHECK(strings::formatted_size("{{}}") == 2);
+        CHECK(strings::formatted_size("{}: {} ({:x})", "value", 42, 42) == strings::format("{}: {} ({:x})", "value", 42, 42).size());
+        CHECK(strings::formatted_size("[{:300d}] {:.3f} {}", 1, 2.5, longText) == 309 + longText.size());
+        REQUIRE(strings::formatted_size("{1}{0}{1}", L"wide", longText) == 2 * longText.size() + 4);
+    }
+
+    SECTION("short output doesn't reserve") {
+        reserve_counting_sink sink;
+        strings::format_to(sink, "{} {}", 1, 2);
+        CHECK(sink.text == "1 2");
+        REQUIRE(sink.reserveCalls == 0);
+    }
+
+    SECTION("long output is reserved once") {
+        std::string longText(200, 'z');
+        reserve_counting_sink sink;
+        sink.text = "prefix ";
+        size_t result = strings::format_to(sink, "{} {} {} {:500}|{}", longText, longText, 1.5, "x", longText);
+        CHECK(result == 3 * longText.size() + 3 + 3 + 500 + 1);
+        CHECK(sink.text.size() == 7 + result);
+        CHECK(sink.reserveCalls == 1);
+        REQUIRE(sink.reserved == sink.text.size());
+    }
+
+    SECTION("malformed pattern") {
+        REQUIRE_THROWS_AS(strings::formatted_size("{}"), const std::invalid_argument &);
+    }
+}
+
+namespace
+{
+    struct order_id
+    {
+        uint32_t venue;
+        uint64_t sequence;
+    };
+
+    struct price_level
+    {
+        double price;
+        int64_t quantity;
+    };
+
+    struct endpoint
+    {
+        std::string host;
+        uint16_t port;
+    };
+}
+
+namespace strings
+{
+    template <>
+    struct formatter_traits<order_id>
+    {
+        template <class Sink>
+        static void format(Sink &sink, const order_id &value, const format_spec &)
+        {
+            format_to(sink, "{}-{:08x}", value.venue, value.sequence);
+        }
+    };
+
+    template <>
+    struct formatter_traits<price_level>
+    {
+        template <class Sink>
+        static void format(Sink &sink, const price_level &value, const format_spec &spec)
+        {
+            format_spec priceSpec = default_format_spec();
+            priceSpec.type = 'f';
+            priceSpec.precision = spec.precision >= 0 ? spec.precision : 2;
+            char buffer[64];
+            size_t length = get_formatter(value.price).format(buffer, sizeof(buffer), priceSpec);
+            sink.append(buffer, length);
+            sink.append(" x ", 3);
+            length = get_formatter(value.quantity).format(buffer, sizeof(buffer));
+            sink.append(buffer, length);
+        }
+    };
+
+    template <>
+    struct formatter_traits<endpoint>
+    {
+        static int formatCalls;
+
+        template <class Sink>
+        static void format(Sink &sink, const endpoint &value, const format_spec &)
+        {
+            ++formatCalls;
+            format_to(sink, "{}:{}", value.host, value.port);
+        }
+
+        static size_t size(const endpoint &value, const format_spec &)
+        {
+            return value.host.size() + 1 + get_formatter(value.port).size();
+        }
+    };
+    int formatter_traits<endpoint>::formatCalls = 0;
+}
+
+TEST_CASE("formatter traits tests", "[format]") {
+    char buffer[64]{};
+
+    SECTION("types with traits are formattable") {
+        CHECK(strings::detail::has_formatter_traits<order_id>::value);
+        CHECK(strings::detail::has_formatter_traits<endpoint>::value);
+        CHECK_FALSE(strings::detail::has_formatter_traits<int>::value);
+        CHECK_FALSE(strings::detail::has_formatter_traits<std::string>::value);
+        CHECK(strings::detail::has_formatter_traits_size<endpoint>::value);
+        REQUIRE_FALSE(strings::detail::has_formatter_traits_size<order_id>::value);
+    }
+
+    SECTION("user type formatter") {
+        order_id id = { 7, 0xbeef };
+        strings::formatter formatter = strings::get_formatter(id);
+        size_t result = formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 10);
+        CHECK(formatter.size() == 10);
+        REQUIRE(std::string("7-0000beef") == buffer);
+    }
+
+    SECTION("user types in format pattern") {
+        order_id id = { 1, 255 };
+        price_level level = { 101.255, 300 };
+        endpoint peer = { "example.org", 443 };
+        CHECK(strings::format("{} {} {}", id, level, peer) == "1-000000ff 101.25 x 300 example.org:443");
+        REQUIRE(strings::format("{:.3}", level) == "101.255 x 300");
+    }
+
+    SECTION("width is applied to user type") {
+        order_id id = { 1, 1 };
+        CHECK(strings::format("[{:14}]", id) == "[    1-00000001]");
+        CHECK(strings::format("[{:-14}]", id) == "[1-00000001    ]");
+        REQUIRE(strings::format("[{:=^15}]", id) == "[==1-00000001===]");
+    }
+
+    SECTION("output is truncated to buffer size") {
+        endpoint peer = { "example.org", 443 };
+        strings::formatter formatter = strings::get_formatter(peer);
+        size_t result = formatter.format(buffer, 8);
+        CHECK(result == 7);
+        REQUIRE(std::string("example") == buffer);
+    }
+
+    SECTION("size function is used for measuring") {
+        endpoint peer = { "example.org", 8080 };
+        strings::formatter formatter = strings::get_formatter(peer);
+        strings::formatter_traits<endpoint>::formatCalls = 0;
+        CHECK(formatter.size() == 16);
+        CHECK(strings::formatter_traits<endpoint>::formatCalls == 0);
+        REQUIRE(strings::formatted_size("<{}>", peer) == 18);
+    }
+
+    SECTION("value is copied into formatter") {
+        endpoint peer = { "example.org", 80 };
+        strings::formatter formatter = strings::get_formatter(peer);
+        peer.host = "changed";
+        formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        REQUIRE(std::string("example.org:80") == buffer);
+    }
+}
@@ -0,0 +1,343 @@
+#include <catch/catch.hpp>
+#include <strings/checked_format.h>
+#include <strings/deferred_format.h>
+#include <strings/escape_format.h>
+#include <strings/format.h>
+#include <strings/formatter.h>
+#include <strings/sinks.h>
+#include <strings/string_functions.h>
+#include <utility/benchmark.h>
+#include <array_size.h>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const size_t iterations = 2000000;
+}
+
+TEST_CASE("integer formatter benchmark", "[.][benchmark][formatter]")
+{
+    char buffer[64];
+    const int64_t base = 1234567;
+
+    double printfDecimal = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), "%td", ptrdiff_t(base * i));
+    });
+    double nativeDecimal = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::get_formatter(int64_t(base * i)).format(buffer, ArraySize(buffer));
+    });
+
+    strings::format_options hexOptions{"%08llX"};
+    double printfHex = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), hexOptions.formatString, (long long)(base * i));
+    });
+    double nativeHex = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::get_formatter(int64_t(base * i)).format(buffer, ArraySize(buffer), &hexOptions);
+    });
+
+    utility::report_benchmark("str_printf(\"%td\")", printfDecimal);
+    utility::report_benchmark("signed_integer_format (default)", nativeDecimal, printfDecimal);
+    utility::report_benchmark("str_printf(\"%08llX\")", printfHex);
+    utility::report_benchmark("signed_integer_format (\"%08llX\")", nativeHex, printfHex);
+}
+
+TEST_CASE("hex formatter benchmark", "[.][benchmark][formatter]")
+{
+    char buffer[64];
+    const uint64_t base = 0x9E3779B97F4A7C15ULL;
+
+    strings::format_options fixedOptions{"%#018llx"};
+    double printfFixed = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), fixedOptions.formatString, (unsigned long long)(base * i));
+    });
+    double nativeFixed = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::get_formatter(uint64_t(base * i)).format(buffer, ArraySize(buffer), &fixedOptions);
+    });
+
+    double printfPointer = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), "%p", reinterpret_cast<void *>(uintptr_t(base * i)));
+    });
+    double nativePointer = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::get_formatter(reinterpret_cast<void *>(uintptr_t(base * i))).format(buffer, ArraySize(buffer));
+    });
+
+    std::vector<unsigned char> bytes(256);
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = (unsigned char)(base >> (i % 8 * 8));
+    char dump[1024];
+    double bufferToString = utility::measure_nanoseconds(iterations / 16, [&](size_t) {
+        return strings::buffer_to_string(dump, ArraySize(dump), bytes.data(), bytes.size(), ' ');
+    });
+
+    utility::report_benchmark("str_printf(\"%#018llx\")", printfFixed);
+    utility::report_benchmark("unsigned_integer_format (\"%#018llx\")", nativeFixed, printfFixed);
+    utility::report_benchmark("str_printf(\"%p\")", printfPointer);
+    utility::report_benchmark("pointer_format (default)", nativePointer, printfPointer);
+    utility::report_benchmark("buffer_to_string (256 bytes)", bufferToString);
+}
+
+TEST_CASE("floating point formatter benchmark", "[.][benchmark][formatter]")
+{
+    char buffer[64];
+    // typical telemetry: latencies, ratios, temperatures
+    const double values[] = { 0.001234, 12.5, 98.6, 1013.25, 0.75, 3.3333333333333335, 42.0, 1e-9, 65535.5, 299792458.0, 0.1, 271.15 };
+    const size_t count = ArraySize(values);
+
+    double printf17g = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), "%.17g", values[i % count]);
+    });
+    double nativeShortest = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::get_formatter(values[i % count]).format(buffer, ArraySize(buffer));
+    });
+
+    strings::format_options fixedOptions{"%.3f"};
+    double printfFixed = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), fixedOptions.formatString, values[i % count]);
+    });
+    double nativeFixed = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::get_formatter(values[i % count]).format(buffer, ArraySize(buffer), &fixedOptions);
+    });
+
+    utility::report_benchmark("str_printf(\"%.17g\")", printf17g);
+    utility::report_benchmark("double_format (shortest)", nativeShortest, printf17g);
+    utility::report_benchmark("str_printf(\"%.3f\")", printfFixed);
+    utility::report_benchmark("double_format (\"%.3f\")", nativeFixed, printfFixed);
+}
+
+TEST_CASE("multithreaded formatter benchmark", "[.][benchmark][formatter]")
+{
+    const size_t threadIterations = 200000;
+    const size_t threadCounts[] = { 1, 4, 16, 32 };
+    const double values[] = { 0.001234, 12.5, 98.6, 1013.25, 0.75, 3.3333333333333335, 42.0, 1e-9, 65535.5, 299792458.0, 0.1, 271.15 };
+    const size_t count = ArraySize(values);
+    strings::format_options fixedOptions{"%.3f"};
+
+    for (size_t threads : threadCounts)
+    {
+        double printfFixed = utility::measure_parallel_nanoseconds(threads, threadIterations, [&](size_t, size_t i) {
+            char buffer[64];
+            return strings::str_printf(buffer, ArraySize(buffer), "%.3f %td", values[i % count], ptrdiff_t(i));
+        });
+        double nativeFixed = utility::measure_parallel_nanoseconds(threads, threadIterations, [&](size_t, size_t i) {
+            char buffer[64];
+            size_t length = strings::get_formatter(values[i % count]).format(buffer, ArraySize(buffer), &fixedOptions);
+            buffer[length++] = ' ';
+            return length + strings::get_formatter(ptrdiff_t(i)).format(buffer + length, ArraySize(buffer) - length);
+        });
+
+        std::string threadsName = " x" + std::to_string(threads) + " threads";
+        utility::report_benchmark(("str_printf(\"%.3f %td\")" + threadsName).c_str(), printfFixed);
+        utility::report_benchmark(("native (\"%.3f\", default)" + threadsName).c_str(), nativeFixed, printfFixed);
+    }
+}
+
+TEST_CASE("string formatter benchmark", "[.][benchmark][formatter]")
+{
+    static char buffer[8192];
+    const size_t payloadIterations = 200000;
+    std::string payload(4096, 'p');
+
+    double nullTerminated = utility::measure_nanoseconds(payloadIterations, [&](size_t) {
+        return strings::get_formatter(payload.c_str()).format(buffer, ArraySize(buffer));
+    });
+    double knownLength = utility::measure_nanoseconds(payloadIterations, [&](size_t) {
+        return strings::get_formatter(payload).format(buffer, ArraySize(buffer));
+    });
+
+    utility::report_benchmark("char_str_format (4KB, null-terminated)", nullTerminated);
+    utility::report_benchmark("char_str_format (4KB, known length)", knownLength, nullTerminated);
+}
+
+TEST_CASE("escape formatter benchmark", "[.][benchmark][formatter]")
+{
+    // log message with a few characters to escape
+    std::string message;
+    for (int i = 0; message.size() < 1024; ++i)
+        message += i % 8 == 7 ? "path=\"C:\\temp\"\n" : "request processed without errors; ";
+    std::vector<char> buffer(4096);
+
+    double byteByByte = utility::measure_nanoseconds(iterations / 10, [&](size_t) {
+        size_t length = 0;
+        for (char c : message)
+        {
+            if (c == '"' || c == '\\')
+            {
+                buffer[length++] = '\\';
+                buffer[length++] = c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+                length += strings::str_printf(&buffer[length], buffer.size() - length, c == '\n' ? "\\n" : "\\u%04x", unsigned(c));
+            else
+                buffer[length++] = c;
+        }
+        buffer[length] = '\0';
+        return length;
+    });
+    double vectorized = utility::measure_nanoseconds(iterations / 10, [&](size_t) {
+        return strings::get_formatter(strings::json_escaped(message)).format(&buffer[0], buffer.size());
+    });
+
+    utility::report_benchmark("JSON escaping (1KB, byte by byte)", byteByByte);
+    utility::report_benchmark("escaped_str_format (1KB, JSON)", vectorized, byteByByte);
+}
+
+TEST_CASE("timestamp formatter benchmark", "[.][benchmark][formatter]")
+{
+    char buffer[64];
+    const int64_t start = strings::timestamp::now().time;
+    // one log line per microsecond
+    const int64_t step = 1000;
+
+    double printfTimestamp = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        int64_t time = start + int64_t(i) * step;
+        std::time_t seconds = std::time_t(time / 1000000000);
+        std::tm parts;
+#if defined(_WIN32)
+        gmtime_s(&parts, &seconds);
+#else
+        gmtime_r(&seconds, &parts);
+#endif
+        return strings::str_printf(buffer, ArraySize(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+            parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec,
+            int(time / 1000000 % 1000));
+    });
+    utility::report_benchmark("gmtime + str_printf (ms)", printfTimestamp);
+
+    const strings::timestamp::precision_type precisions[] = {
+        strings::timestamp::milliseconds, strings::timestamp::microseconds, strings::timestamp::nanoseconds
+    };
+    const char *names[] = { "timestamp_format (UTC, ms)", "timestamp_format (UTC, us)", "timestamp_format (UTC, ns)" };
+    for (size_t p = 0; p < ArraySize(precisions); ++p)
+    {
+        double cached = utility::measure_nanoseconds(iterations, [&](size_t i) {
+            strings::timestamp value = { start + int64_t(i) * step, precisions[p], strings::timestamp::utc };
+            return strings::get_formatter(value).format(buffer, ArraySize(buffer));
+        });
+        utility::report_benchmark(names[p], cached, printfTimestamp);
+    }
+
+    double local = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        strings::timestamp value = { start + int64_t(i) * step, strings::timestamp::milliseconds, strings::timestamp::local };
+        return strings::get_formatter(value).format(buffer, ArraySize(buffer));
+    });
+    utility::report_benchmark("timestamp_format (local, ms)", local, printfTimestamp);
+}
+
+TEST_CASE("format pattern benchmark", "[.][benchmark][format]")
+{
+    char buffer[128];
+    const char *name = "request";
+    const int64_t base = 1234567;
+
+    double printfLine = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), "%s: %lld (%llx)", name, (long long)(base * i), (long long)(base * i));
+    });
+    double formatLine = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        return strings::format_to(sink, "{}: {} ({:x})", name, int64_t(base * i), int64_t(base * i));
+    });
+    double checkedLine = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        return STRINGS_FORMAT_TO(sink, "{}: {} ({:x})", name, int64_t(base * i), int64_t(base * i));
+    });
+
+    utility::report_benchmark("str_printf(\"%s: %lld (%llx)\")", printfLine);
+    utility::report_benchmark("format_to(\"{}: {} ({:x})\")", formatLine, printfLine);
+    utility::report_benchmark("STRINGS_FORMAT_TO(\"{}: {} ({:x})\")", checkedLine, printfLine);
+}
+
+TEST_CASE("format array benchmark", "[.][benchmark][format]")
+{
+    // metrics snapshot: counters of different magnitude
+    const size_t count = 4096;
+    std::vector<uint64_t> counters(count);
+    std::vector<double> gauges(count);
+    uint64_t bits = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < count; ++i)
+    {
+        bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+        counters[i] = bits >> (i % 48);
+        gauges[i] = double(bits >> 40) / 1024.0;
+    }
+    std::string text;
+    text.reserve(count * 32);
+
+    double perElementCounters = utility::measure_nanoseconds(200, [&](size_t) {
+        text.clear();
+        for (size_t i = 0; i < count; ++i)
+            strings::format_to(text, i != 0 ? ",{}" : "{}", counters[i]);
+        return text.size();
+    }) / count;
+    double batchCounters = utility::measure_nanoseconds(200, [&](size_t) {
+        text.clear();
+        return strings::format_array_to(text, counters.data(), count, ",");
+    }) / count;
+    double perElementGauges = utility::measure_nanoseconds(200, [&](size_t) {
+        text.clear();
+        for (size_t i = 0; i < count; ++i)
+            strings::format_to(text, i != 0 ? ",{}" : "{}", gauges[i]);
+        return text.size();
+    }) / count;
+    double batchGauges = utility::measure_nanoseconds(200, [&](size_t) {
+        text.clear();
+        return strings::format_array_to(text, gauges.data(), count, ",");
+    }) / count;
+
+    utility::report_benchmark("format_to per element (uint64_t)", perElementCounters);
+    utility::report_benchmark("format_array_to (uint64_t)", batchCounters, perElementCounters);
+    utility::report_benchmark("format_to per element (double)", perElementGauges);
+    utility::report_benchmark("format_array_to (double)", batchGauges, perElementGauges);
+}
+
+TEST_CASE("deferred format benchmark", "[.][benchmark][format]")
+{
+    // messages stay in buffer until rendered, so buffer holds all of them
+    const size_t messages = 200000;
+    static const strings::pattern_id pattern = strings::register_pattern("{}: {} ({:x})");
+    strings::deferred_buffer deferred(32 * 1024 * 1024);
+    char buffer[128];
+    const char *name = "request";
+    const int64_t base = 1234567;
+
+    // first pass touches whole memory of buffer
+    while (deferred.capture(pattern, name, int64_t(0), int64_t(0)))
+        ;
+    for (bool rendered = true; rendered; )
+    {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        rendered = deferred.render(sink);
+    }
+
+    double printfLine = utility::measure_nanoseconds(messages, [&](size_t i) {
+        return strings::str_printf(buffer, ArraySize(buffer), "%s: %lld (%llx)", name, (long long)(base * i), (long long)(base * i));
+    });
+    double capture = utility::measure_nanoseconds(messages, [&](size_t i) {
+        return deferred.capture(pattern, name, int64_t(base * i), int64_t(base * i));
+    });
+    double render = utility::measure_nanoseconds(messages, [&](size_t) {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        return deferred.render(sink);
+    });
+    REQUIRE(deferred.dropped() == 1);
+
+    // thread alternates between formatters, so each capture looks up buffer of other formatter
+    strings::deferred_formatter first(32 * 1024 * 1024), second(32 * 1024 * 1024);
+    for (strings::deferred_formatter *formatter : { &first, &second })
+    {
+        while (formatter->capture(pattern, name, int64_t(0), int64_t(0)))
+            ;
+        strings::counting_sink sink;
+        formatter->render(sink);
+    }
+    double alternating = utility::measure_nanoseconds(messages, [&](size_t i) {
+        strings::deferred_formatter &formatter = i % 2 == 0 ? first : second;
+        return formatter.capture(pattern, name, int64_t(base * i), int64_t(base * i));
+    });
+
+    utility::report_benchmark("str_printf(\"%s: %lld (%llx)\")", printfLine);
+    utility::report_benchmark("deferred_buffer::capture", capture, printfLine);
+    utility::report_benchmark("deferred_buffer::render", render, printfLine);
+    utility::report_benchmark("deferred_formatter::capture (2 formatters)", alternating, printfLine);
+}
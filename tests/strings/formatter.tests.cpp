@@ -1,5 +1,11 @@
 ﻿#include <catch/catch.hpp>
 #include <strings/formatter.h>
+#include <strings/string_functions.h>
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
 
 TEST_CASE("int formatter tests", "[formatter]") {
     char buffer[1024]{};
@@ -216,6 +222,63 @@ TEST_CASE("std::string formatter tests", "[formatter]") {
         CHECK(result == 22);
         REQUIRE(expected == std::string(buffer));
     }
+    SECTION("std::string with zeros is formatted with its length") {
+        std::string source("a\0b", 3);
+        strings::formatter stringFormatter = strings::get_formatter(source);
+        size_t result = stringFormatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 3);
+        CHECK(stringFormatter.size() == 3);
+        REQUIRE(source == std::string(buffer, result));
+    }
+    SECTION("std::string width and precision match printf") {
+        char expected[1024];
+        std::string source = "string";
+        std::wstring wideSource = L"string";
+        const char *specs[] = { "%s", "%10s", "%-10s", "%.3s", "%8.2s", "%-8.20s", "[%s]", "%.0s" };
+        for (const char *spec : specs) {
+            strings::format_options options{};
+            strcpy(options.formatString, spec);
+            snprintf(expected, sizeof(expected), spec, source.c_str());
+            INFO(spec);
+            CHECK(strings::get_formatter(source).size(&options) == strlen(expected));
+            size_t result = strings::get_formatter(source).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+            CHECK(result == strlen(expected));
+            CHECK(std::string(expected) == buffer);
+
+            CHECK(strings::get_formatter(wideSource).size(&options) == strlen(expected));
+            result = strings::get_formatter(wideSource).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+            CHECK(result == strlen(expected));
+            CHECK(std::string(expected) == buffer);
+        }
+    }
+    SECTION("long std::string is truncated to buffer size") {
+        std::string source(5000, 'x');
+        strings::formatter stringFormatter = strings::get_formatter(source);
+        CHECK(stringFormatter.size() == 5000);
+        size_t result = stringFormatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 1023);
+        REQUIRE(std::string(1023, 'x') == buffer);
+    }
+    SECTION("string view formatter") {
+        const char *text = "string view";
+        strings::formatter viewFormatter = strings::get_formatter(strings::string_view(text, 6));
+        size_t result = viewFormatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 6);
+        REQUIRE("string" == std::string(buffer));
+    }
+    SECTION("wide string view formatter") {
+        const wchar_t *text = L"\x0444\x20ac\U0001F600 end";
+        strings::formatter viewFormatter = strings::get_formatter(strings::wstring_view(text));
+        size_t result = viewFormatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 13);
+        CHECK(viewFormatter.size() == 13);
+        REQUIRE("\xD1\x84\xE2\x82\xAC\xF0\x9F\x98\x80 end" == std::string(buffer));
+
+        // multibyte characters are not split
+        result = viewFormatter.format(buffer, 5);
+        CHECK(result == 2);
+        REQUIRE("\xD1\x84" == std::string(buffer));
+    }
 }
 
 TEST_CASE("pointer formatter tests", "[formatter]") {
@@ -228,4 +291,729 @@ TEST_CASE("pointer formatter tests", "[formatter]") {
         bool deadbeef_match = std::string::npos != std::string(buffer).find("deadbeef");
         REQUIRE((DEADBEEF_match || deadbeef_match));
     }
-}
\ No newline at end of file
+
+    SECTION("hexadecimal specification keeps whole pointer") {
+        if (sizeof(void *) < sizeof(uint64_t))
+            return;
+        void *source = reinterpret_cast<void *>(uintptr_t(0x123456789abcULL));
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec("x", "x" + 1, spec));
+        size_t result = strings::get_formatter(source).format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 12);
+        CHECK(std::string(buffer) == "123456789abc");
+
+        REQUIRE(strings::parse_format_spec("%X", spec));
+        result = strings::get_formatter(source).format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 12);
+        CHECK(std::string(buffer) == "123456789ABC");
+
+        // formatters without specification entry get whole value through format_options
+        REQUIRE(strings::parse_format_spec("x", "x" + 1, spec));
+        strings::formatter packed(source, &strings::unsigned_integer_format, nullptr);
+        result = packed.format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 12);
+        REQUIRE(std::string(buffer) == "123456789abc");
+    }
+}
+TEST_CASE("native integer formatting matches printf", "[formatter]") {
+    char buffer[64]{};
+    char expected[64]{};
+
+    const int64_t values[] = { 0, 1, -1, 7, -7, 42, 100, -100, 255, 65535, 2147483647, -2147483647 - 1, 1234567890123LL, INT64_MAX, INT64_MIN };
+    const char *specs[] = { "%d", "%i", "%u", "%x", "%X", "%o", "%5d", "%-5d|", "%05d", "%+d", "% d", "%.3d", "%#x", "%#X", "%#o", "%.0d", "%08.3x", "%hhd", "%hu", "%lld", "%llx", "%-#10llX", "%+020lld" };
+
+    for (const char *spec : specs) {
+        for (int64_t value : values) {
+            strings::format_options options{};
+            strcpy(options.formatString, spec);
+
+            if (strstr(spec, "ll"))
+                snprintf(expected, sizeof(expected), spec, (long long)value);
+            else
+                snprintf(expected, sizeof(expected), spec, (int)value);
+
+            size_t result = strings::get_formatter(value).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+            INFO(spec << " " << value);
+            CHECK(result == strlen(expected));
+            CHECK(std::string(expected) == buffer);
+        }
+    }
+
+    SECTION("hex digits of every length match printf") {
+        const char *hexSpecs[] = { "%llx", "%llX", "%#llx", "%#018llx", "%016llX", "%.12llx", "%-#20llX|" };
+        for (const char *spec : hexSpecs) {
+            for (unsigned shift = 0; shift < 64; shift += 3) {
+                uint64_t value = 0xF0E1D2C3B4A59687ULL >> shift;
+                strings::format_options options{};
+                strcpy(options.formatString, spec);
+                snprintf(expected, sizeof(expected), spec, (unsigned long long)value);
+                size_t result = strings::get_formatter(value).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+                INFO(spec << " " << value);
+                CHECK(result == strlen(expected));
+                CHECK(std::string(expected) == buffer);
+            }
+        }
+    }
+
+    SECTION("width is taken from format_options when not specified in format string") {
+        strings::format_options options{"%d", 6};
+        size_t result = strings::get_formatter(42).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        CHECK(result == 6);
+        REQUIRE("    42" == std::string(buffer));
+    }
+
+    SECTION("default format prints whole 64-bit value") {
+        size_t result = strings::get_formatter(int64_t(-1234567890123LL)).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 14);
+        CHECK("-1234567890123" == std::string(buffer));
+        result = strings::get_formatter(uint64_t(18446744073709551615ULL)).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 20);
+        REQUIRE("18446744073709551615" == std::string(buffer));
+    }
+
+    SECTION("output is truncated to buffer size") {
+        strings::format_options options{"%08d"};
+        size_t result = strings::get_formatter(42).format(buffer, 5, &options);
+        CHECK(result == 4);
+        REQUIRE("0000" == std::string(buffer));
+    }
+
+    SECTION("unknown format falls back to printf") {
+        strings::format_options options{"[%d]"};
+        size_t result = strings::get_formatter(42).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        CHECK(result == 4);
+        REQUIRE("[42]" == std::string(buffer));
+    }
+}
+
+TEST_CASE("floating point formatter tests", "[formatter]") {
+    char buffer[512]{};
+    char expected[512]{};
+
+    SECTION("shortest representation") {
+        struct { double value; const char *expected; } samples[] = {
+            { 0.1, "0.1" }, { 0.3, "0.3" }, { 1.0, "1" }, { -2.5, "-2.5" }, { 100.0, "100" },
+            { 0.0, "0" }, { -0.0, "-0" }, { 1e-5, "1e-05" }, { 0.0001, "0.0001" },
+            { 1e15, "1000000000000000" }, { 1e16, "1e+16" }, { 123456789012345678.0, "1.2345678901234568e+17" },
+            { 5e-324, "5e-324" }, { 1.7976931348623157e308, "1.7976931348623157e+308" },
+            { 1.0 / 0.0, "inf" }, { -1.0 / 0.0, "-inf" },
+        };
+        for (auto &sample : samples) {
+            size_t result = strings::get_formatter(sample.value).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+            CHECK(result == strlen(sample.expected));
+            CHECK(std::string(sample.expected) == buffer);
+        }
+    }
+
+    SECTION("float uses shortest single precision representation") {
+        size_t result = strings::get_formatter(0.1f).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 3);
+        REQUIRE("0.1" == std::string(buffer));
+    }
+
+    SECTION("shortest representation is read back to the same value") {
+        uint64_t bits = 0x123456789ABCDEFULL;
+        for (int i = 0; i < 10000; ++i) {
+            bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            if (value != value || value - value != 0)
+                continue; // skip nan and infinity
+            strings::get_formatter(value).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+            INFO(buffer);
+            CHECK(strtod(buffer, nullptr) == value);
+        }
+    }
+
+    SECTION("printf conversions match printf") {
+        const double values[] = { 0.0, 0.5, 0.125, 2.5, 1.0 / 3, -2.0 / 3, 1234.5678, 1e-7, 9.9999999, 1e21, 123456789.987654321, 5e-324, -1e300 };
+        const char *specs[] = { "%f", "%.0f", "%.2f", "%.3f", "%e", "%.0e", "%.3E", "%g", "%.3g", "%.17g", "%#g", "%+10.3f", "%-12.4e", "%012.3f", "%.20f" };
+        for (const char *spec : specs) {
+            for (double value : values) {
+                strings::format_options options{};
+                strcpy(options.formatString, spec);
+                snprintf(expected, sizeof(expected), spec, value);
+                size_t result = strings::get_formatter(value).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+                INFO(spec << " " << expected);
+                CHECK(result == strlen(expected));
+                CHECK(std::string(expected) == buffer);
+            }
+        }
+    }
+
+    SECTION("exactly rounded digits match printf") {
+        const double values[] = { 0.5, 1.5, 2.5, 0.125, 0.375, 1e23, 9.5e-5, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308, 0.1, 1.0 / 3 };
+        const char *specs[] = { "%.0f", "%.1f", "%.2f", "%.25f", "%.30e", "%.16e", "%.0e", "%.40g", "%.400f", "%.767e" };
+        std::vector<double> samples(values, values + sizeof(values) / sizeof(values[0]));
+        uint64_t bits = 0xFEDCBA9876543210ULL;
+        for (int i = 0; i < 200; ++i) {
+            bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            if (value == value && value - value == 0)
+                samples.push_back(value);
+        }
+
+        std::vector<char> text(2048), reference(2048);
+        for (const char *spec : specs) {
+            for (double value : samples) {
+                strings::format_options options{};
+                strcpy(options.formatString, spec);
+                snprintf(&reference[0], reference.size(), spec, value);
+                size_t result = strings::get_formatter(value).format(&text[0], text.size(), &options);
+                INFO(spec << " " << &reference[0]);
+                CHECK(result == strlen(&reference[0]));
+                CHECK(std::string(&reference[0]) == &text[0]);
+            }
+        }
+    }
+
+    SECTION("precision larger than native limit is formatted by printf") {
+        const char *specs[] = { "%.2000f", "%+.1500e", "%-2300.2000f|", "%02300.2000f", "%.1200G" };
+        std::vector<char> text(4096), reference(4096);
+        for (const char *spec : specs) {
+            for (double value : { 1.0 / 3, -1e300, 5e-324 }) {
+                strings::format_options options{};
+                strcpy(options.formatString, spec);
+                snprintf(&reference[0], reference.size(), spec, value);
+                size_t result = strings::get_formatter(value).format(&text[0], text.size(), &options);
+                INFO(spec);
+                CHECK(result == strlen(&reference[0]));
+                CHECK(std::string(&reference[0]) == &text[0]);
+            }
+        }
+
+        strings::format_options precisionOptions{"", 0, 2000};
+        snprintf(&reference[0], reference.size(), "%.2000g", 0.1);
+        size_t result = strings::get_formatter(0.1).format(&text[0], text.size(), &precisionOptions);
+        CHECK(result == strlen(&reference[0]));
+        CHECK(std::string(&reference[0]) == &text[0]);
+
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec("%2100.2000f", spec));
+        snprintf(&reference[0], reference.size(), "%2100.2000f", -0.1);
+        result = strings::get_formatter(-0.1).format(&text[0], text.size(), spec);
+        CHECK(result == strlen(&reference[0]));
+        CHECK(strings::get_formatter(-0.1).size(spec) == result);
+        REQUIRE(std::string(&reference[0]) == &text[0]);
+    }
+
+    SECTION("precision and width from format_options") {
+        strings::format_options options{"", 8, 3};
+        size_t result = strings::get_formatter(3.14159).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        CHECK(result == 8);
+        CHECK("    3.14" == std::string(buffer));
+
+        strings::format_options fixedOptions{"%f", 0, 2};
+        result = strings::get_formatter(3.14159).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &fixedOptions);
+        CHECK(result == 4);
+        REQUIRE("3.14" == std::string(buffer));
+    }
+}
+
+TEST_CASE("format specification tests", "[formatter]") {
+    char buffer[64]{};
+    char expected[64]{};
+
+    SECTION("parse printf-like format string") {
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec("%-#12.5llX", spec));
+        CHECK(spec.native);
+        CHECK(spec.type == 'X');
+        CHECK(spec.alignment == strings::format_spec::align_left);
+        CHECK(spec.alternate);
+        CHECK(spec.width == 12);
+        CHECK(spec.precision == 5);
+        CHECK(spec.base == 16);
+        CHECK(spec.upper);
+        CHECK(spec.bits == sizeof(long long) * 8);
+    }
+
+    SECTION("empty format string means default formatting") {
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec("", spec));
+        CHECK(spec.native);
+        CHECK(spec.type == 0);
+        CHECK(spec.precision == -1);
+    }
+
+    SECTION("format string with text can't be compiled") {
+        strings::format_spec spec;
+        CHECK_FALSE(strings::parse_format_spec("value=%d", spec));
+        CHECK_FALSE(spec.native);
+        CHECK_FALSE(strings::parse_format_spec("%*d", spec));
+        CHECK_FALSE(strings::parse_format_spec("%n", spec));
+    }
+
+    SECTION("compiled specification is used by formatter") {
+        strings::format_spec spec;
+        strings::parse_format_spec("%08.3f", spec);
+        size_t result = strings::get_formatter(-3.14159).format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 8);
+        CHECK("-003.142" == std::string(buffer));
+
+        strings::parse_format_spec("%#x", spec);
+        result = strings::get_formatter(uint32_t(255)).format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 4);
+        REQUIRE("0xff" == std::string(buffer));
+    }
+
+    SECTION("alignment and fill from format_options") {
+        strings::format_options centered{"", 10, 0, strings::format_spec::align_center, '.'};
+        size_t result = strings::get_formatter("name").format(buffer, sizeof(buffer) / sizeof(buffer[0]), &centered);
+        CHECK(result == 10);
+        CHECK("...name..." == std::string(buffer));
+
+        strings::format_options left{"", 8, 0, strings::format_spec::align_left};
+        result = strings::get_formatter(3.5).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &left);
+        CHECK(result == 8);
+        CHECK("3.5     " == std::string(buffer));
+
+        strings::format_options truncated{"", 6, 3, strings::format_spec::align_right, '-'};
+        result = strings::get_formatter(std::wstring(L"truncated")).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &truncated);
+        CHECK(result == 6);
+        CHECK("---tru" == std::string(buffer));
+
+        strings::format_options zeros{"%08.2f", 0, 0, strings::format_spec::align_center, '*'};
+        result = strings::get_formatter(-1.5).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &zeros);
+        CHECK(result == 8);
+        CHECK("*-1.50**" == std::string(buffer));
+
+        strings::format_spec spec = strings::default_format_spec();
+        spec.width = 7;
+        spec.alignment = strings::format_spec::align_center;
+        spec.fill = '#';
+        result = strings::get_formatter(uint32_t(42)).format(buffer, 6, spec);
+        CHECK(result == 5);
+        CHECK("##42#" == std::string(buffer));
+        REQUIRE(strings::get_formatter(uint32_t(42)).size(spec) == 7);
+    }
+
+    SECTION("format_options changed after use are applied") {
+        strings::format_options options{"%5d"};
+        size_t result = strings::get_formatter(42).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        CHECK(result == 5);
+        CHECK("   42" == std::string(buffer));
+
+        strcpy(options.formatString, "%-4x");
+        result = strings::get_formatter(255).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        CHECK(result == 4);
+        CHECK("ff  " == std::string(buffer));
+
+        strcpy(options.formatString, "");
+        options.width = 6;
+        result = strings::get_formatter(42).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        CHECK(result == 6);
+        REQUIRE("    42" == std::string(buffer));
+    }
+
+    SECTION("format_options made from compiled specification") {
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec("%+08.3hhx", spec));
+        strings::format_options options = strings::make_format_options(spec);
+        CHECK(std::string(options.formatString) == "%+0.3hhx");
+        CHECK(options.width == 8);
+        strings::format_spec parsed = options.get_spec();
+        CHECK(parsed.plus);
+        CHECK(parsed.zero);
+        CHECK(parsed.width == 8);
+        CHECK(parsed.precision == 3);
+        CHECK(parsed.bits == 8);
+        CHECK(parsed.type == 'x');
+
+        // whole value of pattern specification keeps its width
+        REQUIRE(strings::parse_format_spec("#x", "#x" + 2, spec));
+        options = strings::make_format_options(spec);
+        REQUIRE(std::string(options.formatString) == "%#llx");
+    }
+
+    SECTION("format_options keep explicit zero precision of untyped specification") {
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec(">4.0", ">4.0" + 4, spec));
+        strings::format_options options = strings::make_format_options(spec);
+        CHECK(options.get_spec().precision == 0);
+        strings::formatter text(const_cast<char *>("text"), &strings::char_str_format, nullptr);
+        size_t result = text.format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 4);
+        CHECK(std::string(buffer) == "    ");
+
+        REQUIRE(strings::parse_format_spec(">4", ">4" + 2, spec));
+        options = strings::make_format_options(spec);
+        CHECK(options.get_spec().precision == -1);
+        result = text.format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec);
+        CHECK(result == 4);
+        REQUIRE(std::string(buffer) == "text");
+    }
+
+    SECTION("strings, chars and bools with width and precision match printf") {
+        const char *specs[] = { "%s", "%10s", "%-10s", "%.3s", "%8.2s", "%-8.20s" };
+        for (const char *spec : specs) {
+            strings::format_options options{};
+            strcpy(options.formatString, spec);
+            snprintf(expected, sizeof(expected), spec, "string");
+            size_t result = strings::get_formatter("string").format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+            INFO(spec);
+            CHECK(result == strlen(expected));
+            CHECK(std::string(expected) == buffer);
+
+            result = strings::get_formatter(L"string").format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+            CHECK(result == strlen(expected));
+            CHECK(std::string(expected) == buffer);
+        }
+
+        strings::format_options charOptions{"%-3c"};
+        strings::get_formatter('A').format(buffer, sizeof(buffer) / sizeof(buffer[0]), &charOptions);
+        CHECK("A  " == std::string(buffer));
+
+        strings::format_options boolOptions{"%6s"};
+        strings::get_formatter(false).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &boolOptions);
+        REQUIRE(" false" == std::string(buffer));
+    }
+}
+
+TEST_CASE("locale independent formatting", "[formatter]") {
+    char buffer[64]{};
+    char expected[64]{};
+
+    SECTION("pointers match printf") {
+        int value = 0;
+        void *pointers[] = { &value, nullptr, (void *)0xDEADBEEF };
+        const char *specs[] = { "%p", "%20p", "%-20p|" };
+        for (void *pointer : pointers) {
+            for (const char *spec : specs) {
+                strings::format_options options{};
+                strcpy(options.formatString, spec);
+                snprintf(expected, sizeof(expected), spec, pointer);
+                size_t result = strings::get_formatter(pointer).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+                INFO(spec << " " << expected);
+                CHECK(result == strlen(expected));
+                CHECK(std::string(expected) == buffer);
+            }
+        }
+    }
+
+    SECTION("grouping flag is parsed natively") {
+        strings::format_spec spec;
+        REQUIRE(strings::parse_format_spec("%'12.2f", spec));
+        CHECK(spec.native);
+        CHECK(spec.localized);
+        CHECK(spec.width == 12);
+        REQUIRE(strings::parse_format_spec("'d", "'d" + 2, spec));
+        CHECK(spec.localized);
+        CHECK_FALSE(strings::default_format_spec().localized);
+    }
+
+    SECTION("native formatting ignores C locale, grouping flag uses it") {
+        const char *locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "German_Germany.1252", "fr_FR.UTF-8", "ru_RU.UTF-8" };
+        std::string previous = setlocale(LC_NUMERIC, nullptr);
+        const char *installed = nullptr;
+        for (const char *locale : locales) {
+            if (setlocale(LC_NUMERIC, locale) != nullptr) {
+                installed = locale;
+                break;
+            }
+        }
+
+        const char *specs[] = { "%'d", "%'.2f", "%'g", "%'e", "%'10.1f" };
+        std::vector<std::string> localized, printed;
+        for (const char *spec : specs) {
+            strings::format_options options{};
+            strcpy(options.formatString, spec);
+            if (spec[2] == 'd') {
+                strings::get_formatter(1234567).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+                snprintf(expected, sizeof(expected), spec, 1234567);
+            } else {
+                strings::get_formatter(1234567.5).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+                snprintf(expected, sizeof(expected), spec, 1234567.5);
+            }
+            localized.push_back(buffer);
+            printed.push_back(expected);
+        }
+
+        strings::get_formatter(1234567.5).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        std::string native = buffer;
+        strings::format_options fixed{"%.2f"};
+        strings::get_formatter(1234567.5).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &fixed);
+        std::string nativeFixed = buffer;
+        strings::get_formatter(1234567).format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        std::string nativeInteger = buffer;
+        setlocale(LC_NUMERIC, previous.c_str());
+
+        INFO((installed ? installed : "no localized locale is installed"));
+        CHECK(native == "1234567.5");
+        CHECK(nativeFixed == "1234567.50");
+        CHECK(nativeInteger == "1234567");
+        for (size_t i = 0; i < localized.size(); ++i) {
+            INFO(specs[i]);
+            CHECK(localized[i] == printed[i]);
+        }
+    }
+}
+
+TEST_CASE("formatter measuring mode", "[formatter]") {
+    char buffer[2048]{};
+    int value = -42;
+    std::wstring wideText = L"\x0444\x0438\x0441\x0432 \x20ac text";
+
+    struct measure_case {
+        strings::formatter formatter;
+        std::vector<const char *> specs;
+    };
+    std::vector<measure_case> cases;
+    cases.push_back({ strings::get_formatter(value), { "%d", "%x", "%#o", "%+08d", "%.30d", "%-12i", "[%d]" } });
+    cases.push_back({ strings::get_formatter(uint64_t(UINT64_MAX)), { "%llu", "%llx", "%30llu" } });
+    cases.push_back({ strings::get_formatter(true), { "%s", "%10s", "%.2s", "%d" } });
+    cases.push_back({ strings::get_formatter('c'), { "%c", "%-5c", "%x" } });
+    cases.push_back({ strings::get_formatter(L'\x20ac'), { "%d", "%8x" } });
+    cases.push_back({ strings::get_formatter("string"), { "%s", "%20s", "%-8.3s", "[%s]" } });
+    cases.push_back({ strings::get_formatter(wideText), { "%s", "%30s", "%-30s", "%.5s" } });
+    cases.push_back({ strings::get_formatter(12345.678), { "%f", "%.2f", "%e", "%G", "%+20.3e", "%.1500f", "[%g]" } });
+    cases.push_back({ strings::get_formatter(0.1f), { "%f", "%g", "%.9g" } });
+    cases.push_back({ strings::get_formatter(&value), { "%p", "%20p", "%x" } });
+
+    SECTION("size is length of formatted value") {
+        for (measure_case &c : cases) {
+            size_t defaultLength = c.formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+            INFO(buffer);
+            CHECK(c.formatter.size() == defaultLength);
+            for (const char *spec : c.specs) {
+                strings::format_options options{};
+                strcpy(options.formatString, spec);
+                size_t length = c.formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+                INFO(spec << " -> " << buffer);
+                CHECK(c.formatter.size(&options) == length);
+            }
+        }
+    }
+
+    SECTION("size doesn't depend on buffer size") {
+        strings::formatter formatter = strings::get_formatter("string");
+        strings::format_spec spec = strings::default_format_spec();
+        spec.width = 10;
+        CHECK(formatter.format(buffer, 4, spec) == 3);
+        REQUIRE(formatter.size(spec) == 10);
+    }
+
+    SECTION("wide string precision limits narrowed length") {
+        strings::formatter formatter = strings::get_formatter(wideText);
+        for (int precision = 0; precision < 20; ++precision) {
+            strings::format_spec spec = strings::default_format_spec();
+            spec.precision = precision;
+            INFO(precision);
+            CHECK(formatter.size(spec) == formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]), spec));
+        }
+    }
+}
+
+namespace
+{
+    struct point
+    {
+        int64_t x;
+        int64_t y;
+    };
+
+    struct point_traits
+    {
+        static size_t format(char *buffer, size_t bufferSize, const strings::format_options *, const point &value)
+        {
+            if (buffer == nullptr)
+                return size_t(snprintf(nullptr, 0, "(%lld, %lld)", (long long)value.x, (long long)value.y));
+            return strings::str_printf(buffer, bufferSize, "(%lld, %lld)", (long long)value.x, (long long)value.y);
+        }
+    };
+
+    /// Counts live instances to check that formatter destroys stored values
+    struct counted
+    {
+        static int instances;
+        std::string text;
+
+        explicit counted(const char *value) : text(value) { ++instances; }
+        counted(const counted &other) : text(other.text) { ++instances; }
+        counted(counted &&other) : text(std::move(other.text)) { ++instances; }
+        ~counted() { --instances; }
+    };
+    int counted::instances = 0;
+
+    struct counted_traits
+    {
+        static size_t format(char *buffer, size_t bufferSize, const strings::format_options *format, const counted &value)
+        {
+            return strings::char_str_format(buffer, bufferSize, format, const_cast<char *>(value.text.c_str()));
+        }
+    };
+
+    struct large_value
+    {
+        char text[64];
+    };
+
+    struct large_value_traits
+    {
+        static size_t format(char *buffer, size_t bufferSize, const strings::format_options *format, const large_value &value)
+        {
+            return strings::char_str_format(buffer, bufferSize, format, const_cast<char *>(value.text));
+        }
+    };
+}
+
+TEST_CASE("formatter storage tests", "[formatter]") {
+    char buffer[128]{};
+
+    SECTION("value up to inline size is stored inside of formatter") {
+        point value = { 3, -4 };
+        strings::formatter formatter = strings::formatter::create<point_traits>(value);
+        size_t result = formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(result == 7);
+        CHECK(formatter.size() == 7);
+        REQUIRE(std::string("(3, -4)") == buffer);
+    }
+
+    SECTION("large value is stored on heap") {
+        large_value value = {};
+        strcpy(value.text, "large value");
+        strings::formatter formatter = strings::formatter::create<large_value_traits>(value);
+        strcpy(value.text, "changed");
+        formatter.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        REQUIRE(std::string("large value") == buffer);
+    }
+
+    SECTION("formatter is movable") {
+        strings::formatter first = strings::get_formatter(1.5);
+        strings::formatter second = std::move(first);
+        CHECK(first.format(buffer, sizeof(buffer) / sizeof(buffer[0])) == 0);
+        second.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        CHECK(std::string("1.5") == buffer);
+
+        first = strings::get_formatter("text");
+        second = std::move(first);
+        second.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+        REQUIRE(std::string("text") == buffer);
+    }
+
+    SECTION("stored values are destroyed") {
+        {
+            std::vector<strings::formatter> formatters;
+            for (int i = 0; i < 10; ++i)
+                formatters.push_back(strings::formatter::create<counted_traits>(counted("value")));
+            CHECK(counted::instances == 10);
+
+            strings::formatter moved = std::move(formatters.front());
+            moved = std::move(formatters.back());
+            CHECK(counted::instances == 9);
+            moved.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+            CHECK(std::string("value") == buffer);
+        }
+        REQUIRE(counted::instances == 0);
+    }
+
+    SECTION("cleaner is called for function formatter") {
+        static int cleaned = 0;
+        cleaned = 0;
+        {
+            strings::formatter formatter(reinterpret_cast<void *>(42), &strings::signed_integer_format, [](void *) { ++cleaned; });
+            strings::formatter moved = std::move(formatter);
+            moved.format(buffer, sizeof(buffer) / sizeof(buffer[0]));
+            CHECK(std::string("42") == buffer);
+        }
+        REQUIRE(cleaned == 1);
+    }
+}
+
+namespace
+{
+    std::string format_timestamp(const strings::timestamp &value, const char *formatString = "")
+    {
+        char buffer[128];
+        strings::format_options options{};
+        strcpy(options.formatString, formatString);
+        size_t length = strings::get_formatter(value).format(buffer, sizeof(buffer) / sizeof(buffer[0]), &options);
+        return std::string(buffer, length);
+    }
+
+    std::string strftime_text(const std::tm *parts)
+    {
+        char buffer[64];
+        size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", parts);
+        return std::string(buffer, length);
+    }
+}
+
+TEST_CASE("timestamp formatter tests", "[formatter]") {
+    typedef strings::timestamp timestamp;
+    const int64_t second = 1000000000;
+
+    SECTION("UTC timestamp") {
+        timestamp epoch = { 0, timestamp::milliseconds, timestamp::utc };
+        CHECK(format_timestamp(epoch) == "1970-01-01T00:00:00.000Z");
+
+        timestamp value = { 1714566896 * second + 789123456, timestamp::milliseconds, timestamp::utc };
+        CHECK(format_timestamp(value) == "2024-05-01T12:34:56.789Z");
+        value.precision = timestamp::microseconds;
+        CHECK(format_timestamp(value) == "2024-05-01T12:34:56.789123Z");
+        value.precision = timestamp::nanoseconds;
+        CHECK(format_timestamp(value) == "2024-05-01T12:34:56.789123456Z");
+        value.precision = timestamp::seconds;
+        REQUIRE(format_timestamp(value) == "2024-05-01T12:34:56Z");
+    }
+
+    SECTION("timestamp before epoch") {
+        timestamp value = { -1, timestamp::nanoseconds, timestamp::utc };
+        CHECK(format_timestamp(value) == "1969-12-31T23:59:59.999999999Z");
+        value.time = -86400 * second * 365;
+        REQUIRE(format_timestamp(value) == "1969-01-01T00:00:00.000000000Z");
+    }
+
+    SECTION("format specification overrides precision and sets width") {
+        timestamp value = { 1714566896 * second + 789123456, timestamp::milliseconds, timestamp::utc };
+        CHECK(format_timestamp(value, "%.6s") == "2024-05-01T12:34:56.789123Z");
+        CHECK(format_timestamp(value, "%.0s") == "2024-05-01T12:34:56Z");
+        CHECK(format_timestamp(value, "%.20s") == "2024-05-01T12:34:56.789123456Z");
+        REQUIRE(format_timestamp(value, "%-26s") == "2024-05-01T12:34:56.789Z  ");
+    }
+
+    SECTION("UTC timestamps match gmtime") {
+        for (int64_t time = -2208988800LL; time < 4102444800LL; time += 7919 * 3607) {
+            std::time_t t = std::time_t(time);
+            timestamp value = { time * second, timestamp::seconds, timestamp::utc };
+            INFO(time);
+            CHECK(format_timestamp(value) == strftime_text(std::gmtime(&t)) + "Z");
+        }
+    }
+
+    SECTION("local timestamps match localtime") {
+        for (int64_t time = 0; time < 2000000000LL; time += 7919 * 3607) {
+            std::time_t t = std::time_t(time);
+            timestamp value = { time * second + 5 * second / 10, timestamp::milliseconds, timestamp::local };
+            std::string text = format_timestamp(value);
+            INFO(time);
+            REQUIRE(text.size() == 29);
+            CHECK(text.substr(0, 19) == strftime_text(std::localtime(&t)));
+            CHECK(text.substr(19, 4) == ".500");
+            CHECK((text[23] == '+' || text[23] == '-'));
+            CHECK(text[26] == ':');
+        }
+    }
+
+    SECTION("cached seconds are updated") {
+        timestamp value = { 1714566896 * second, timestamp::milliseconds, timestamp::utc };
+        for (int i = 0; i < 3000; ++i) {
+            value.time += second / 1000;
+            std::time_t t = std::time_t(value.time / second);
+            std::string expected = strftime_text(std::gmtime(&t));
+            std::string text = format_timestamp(value);
+            CHECK(text.substr(0, 19) == expected);
+        }
+        timestamp local = { value.time, timestamp::milliseconds, timestamp::local };
+        CHECK(format_timestamp(local).size() == 29);
+        REQUIRE(format_timestamp(value).back() == 'Z');
+    }
+
+    SECTION("timestamp now") {
+        timestamp value = timestamp::now(timestamp::microseconds);
+        CHECK(value.precision == timestamp::microseconds);
+        CHECK(value.zone == timestamp::utc);
+        REQUIRE(format_timestamp(value).size() == 27);
+    }
+}
@@ -0,0 +1,63 @@
+﻿#include <catch/catch.hpp>
+#include <strings/format.h>
+#include <strings/hashing_sink.h>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    uint64_t xxhash(const std::string &text, uint64_t seed = 0)
+    {
+        strings::xxhash64 hash(seed);
+        hash.update(text.data(), text.size());
+        return hash.digest();
+    }
+
+    uint32_t crc(const std::string &text)
+    {
+        strings::crc32c checksum;
+        checksum.update(text.data(), text.size());
+        return checksum.value();
+    }
+}
+
+TEST_CASE("xxhash64 tests", "[sinks][hash]") {
+    SECTION("reference values") {
+        CHECK(xxhash("") == 0xEF46DB3751D8E999ULL);
+        CHECK(xxhash("a") == 0xD24EC4F1A98C6E5BULL);
+        CHECK(xxhash("abc") == 0x44BC2CF5AD770999ULL);
+        CHECK(xxhash("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ULL);
+        REQUIRE(xxhash("", 1) != xxhash(""));
+    }
+
+    SECTION("incremental hash matches single update for any split") {
+        std::string text;
+        for (int i = 0; i < 200; ++i)
+            text += char('a' + i % 26);
+        for (size_t split = 0; split <= text.size(); split += 7) {
+            strings::xxhash64 hash;
+            hash.update(text.data(), split);
+            hash.update(text.data() + split, text.size() - split);
+            CHECK(hash.digest() == xxhash(text));
+        }
+    }
+}
+
+TEST_CASE("crc32c tests", "[sinks][hash]") {
+    INFO("hardware crc32: " << strings::crc32c::hardware());
+    CHECK(crc("") == 0);
+    CHECK(crc("123456789") == 0xE3069283);
+    CHECK(crc(std::string(32, '\0')) == 0x8A9136AA);
+    REQUIRE(crc("The quick brown fox jumps over the lazy dog") == 0x22620404);
+}
+
+TEST_CASE("hashing sink tests", "[sinks][hash]") {
+    std::string text = "> ";
+    strings::hashing_sink<std::string> sink(text);
+    strings::format_to(sink, "{}: {} ({:x})", "value", 42, 42);
+    sink.append("!", 1);
+    CHECK(text == "> value: 42 (2a)!");
+    CHECK(sink.size() == text.size());
+    CHECK(sink.hash() == xxhash("value: 42 (2a)!"));
+    REQUIRE(sink.crc() == crc("value: 42 (2a)!"));
+}
@@ -0,0 +1,101 @@
+﻿#include <catch/catch.hpp>
+#include <strings/format.h>
+#include <strings/ring_sink.h>
+#include <string>
+#include <thread>
+
+namespace
+{
+    std::string drain(strings::byte_ring &ring)
+    {
+        strings::string_view spans[2];
+        size_t count = ring.peek(spans);
+        std::string result;
+        for (size_t i = 0; i < count; ++i)
+            result.append(spans[i].data(), spans[i].size());
+        ring.consume(result.size());
+        return result;
+    }
+}
+
+TEST_CASE("ring sink tests", "[sinks]") {
+    strings::byte_ring ring(64);
+    CHECK(ring.capacity() == 64);
+
+    SECTION("record is published on commit") {
+        strings::ring_sink sink(ring);
+        strings::format_to(sink, "{}: {}", "value", 42);
+        CHECK(sink.size() == 9);
+        CHECK(ring.readable() == 0);
+        CHECK(drain(ring) == "");
+        CHECK(sink.commit());
+        CHECK(ring.readable() == 9);
+        REQUIRE(drain(ring) == "value: 42");
+    }
+
+    SECTION("record is published on destruction") {
+        {
+            strings::ring_sink sink(ring);
+            sink.append("abc", 3);
+        }
+        REQUIRE(drain(ring) == "abc");
+    }
+
+    SECTION("record, which doesn't fit, is dropped") {
+        strings::ring_sink sink(ring);
+        std::string large(40, 'x');
+        sink.append(large.data(), large.size());
+        CHECK(sink.commit());
+        sink.append(large.data(), large.size());
+        CHECK_FALSE(sink.commit());
+        CHECK(ring.dropped() == 1);
+        CHECK(ring.writable() == 24);
+        sink.append("abc", 3);
+        CHECK(sink.commit());
+        REQUIRE(drain(ring) == large + "abc");
+    }
+
+    SECTION("content wraps around end of ring") {
+        strings::ring_sink sink(ring);
+        std::string first(50, 'a');
+        sink.append(first.data(), first.size());
+        sink.commit();
+        CHECK(drain(ring) == first);
+
+        std::string second = "0123456789abcdefghij";
+        sink.append(second.data(), second.size());
+        sink.commit();
+        strings::string_view spans[2];
+        CHECK(ring.peek(spans) == 2);
+        CHECK(spans[0].size() == 14);
+        CHECK(spans[1].size() == 6);
+        REQUIRE(drain(ring) == second);
+    }
+
+    SECTION("records are transferred between threads") {
+        const int records = 20000;
+        strings::byte_ring shared(256);
+        std::thread producer([&]() {
+            for (int i = 0; i < records; ++i) {
+                strings::ring_sink sink(shared);
+                while (!shared.fits(strings::formatted_size("{};", i)))
+                    std::this_thread::yield();
+                strings::format_to(sink, "{};", i);
+            }
+        });
+
+        std::string received;
+        std::string expected;
+        for (int i = 0; i < records; ++i)
+            strings::format_to(expected, "{};", i);
+        while (received.size() < expected.size()) {
+            std::string part = drain(shared);
+            if (part.empty())
+                std::this_thread::yield();
+            received += part;
+        }
+        producer.join();
+        CHECK(shared.dropped() == 0);
+        REQUIRE(received == expected);
+    }
+}
@@ -0,0 +1,177 @@
+﻿#include <catch/catch.hpp>
+#include <strings/format.h>
+#include <strings/sharded_sink.h>
+#include <strings/sinks.h>
+#include <platform/thread_functions.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("sharded sink tests", "[sinks]") {
+    strings::sharded_sink shards;
+
+    SECTION("records are merged in order of completion") {
+        {
+            strings::sharded_sink::record record(shards);
+            strings::format_to(record, "{}: {};", "first", 1);
+            CHECK(record.size() == 9);
+            record.commit();
+            CHECK(record.size() == 0);
+            strings::format_to(record, "{}: {};", "second", 2);
+        }
+        std::thread other([&shards]() {
+            strings::sharded_sink::record record(shards);
+            record.append("third;", 6);
+        });
+        other.join();
+        {
+            strings::sharded_sink::record record(shards);
+            record.append("fourth;", 7);
+        }
+        CHECK(shards.published() == 4);
+
+        std::string text;
+        CHECK(shards.merge(text) == 4);
+        CHECK(text == "first: 1;second: 2;third;fourth;");
+        CHECK(shards.merge(text) == 0);
+        REQUIRE(text == "first: 1;second: 2;third;fourth;");
+    }
+
+    SECTION("empty record isn't published") {
+        {
+            strings::sharded_sink::record record(shards);
+            record.append("", 0);
+        }
+        std::string text;
+        CHECK(shards.merge(text) == 0);
+        REQUIRE(shards.published() == 0);
+    }
+
+    SECTION("records are kept when sink throws") {
+        {
+            strings::sharded_sink::record record(shards);
+            record.append("first;", 6);
+            record.commit();
+            record.append("second;", 7);
+        }
+        char buffer[8];
+        strings::static_array_sink small(buffer, sizeof(buffer));
+        CHECK_THROWS_AS(shards.merge(small), std::range_error);
+
+        {
+            strings::sharded_sink::record record(shards);
+            record.append("third;", 6);
+        }
+        std::string text;
+        CHECK(shards.merge(text) == 3);
+        CHECK(text == "first;second;third;");
+
+        {
+            strings::sharded_sink::record record(shards);
+            record.append("fourth;", 7);
+        }
+        CHECK(shards.merge(text) == 1);
+        REQUIRE(text == "first;second;third;fourth;");
+    }
+
+    SECTION("record committed to collected shard is merged before next records") {
+        // merge collects shards in order of thread slots: it takes shard of early thread,
+        // then waits for open record of late thread, while early thread commits its record
+        std::mutex mutex;
+        std::condition_variable changed;
+        int stage = 0;
+        int ready = 0;
+        size_t slots[2] = {};
+        auto waitStage = [&](int value) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return stage >= value; });
+        };
+        auto setStage = [&](int value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            stage = value;
+            changed.notify_all();
+        };
+        auto body = [&](int index) {
+            strings::sharded_sink::record record(shards);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slots[index] = platform::current_thread_slot();
+                ++ready;
+                changed.notify_all();
+                changed.wait(lock, [&]() { return ready == 2; });
+            }
+            if (slots[index] > slots[1 - index]) {
+                record.append("second;", 7);
+                setStage(1);
+                waitStage(3);
+            } else {
+                waitStage(2);
+                record.append("first;", 6);
+                record.commit();
+                setStage(3);
+            }
+        };
+        std::thread first(body, 0);
+        std::thread second(body, 1);
+
+        waitStage(1);
+        std::string merged;
+        size_t mergedCount = 0;
+        std::thread merger([&]() { mergedCount = shards.merge(merged); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        setStage(2);
+        first.join();
+        second.join();
+        merger.join();
+
+        std::string next;
+        size_t nextCount = shards.merge(next);
+        size_t totalCount = mergedCount + nextCount;
+        CHECK(totalCount == 2);
+        merged += next;
+        CHECK(merged == "first;second;");
+        CHECK(shards.merge(next) == 0);
+        REQUIRE(shards.published() == 2);
+    }
+
+    SECTION("records of many threads are merged while threads write") {
+        const int threadsCount = 4;
+        const int records = 5000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadsCount; ++t) {
+            threads.push_back(std::thread([&shards, t, records]() {
+                for (int i = 0; i < records; ++i) {
+                    strings::sharded_sink::record record(shards);
+                    strings::format_to(record, "{}:{};", t, i);
+                }
+            }));
+        }
+
+        std::string text;
+        size_t merged = 0;
+        while (merged < size_t(threadsCount * records))
+            merged += shards.merge(text);
+        for (size_t i = 0; i < threads.size(); ++i)
+            threads[i].join();
+
+        // records of each thread keep their order
+        std::vector<int> next(threadsCount, 0);
+        bool ordered = true;
+        size_t position = 0;
+        while (position < text.size()) {
+            size_t end = text.find(';', position);
+            std::string item = text.substr(position, end - position);
+            int t = std::stoi(item.substr(0, item.find(':')));
+            int i = std::stoi(item.substr(item.find(':') + 1));
+            ordered = ordered && next[t] == i;
+            next[t] = i + 1;
+            position = end + 1;
+        }
+        CHECK(ordered);
+        REQUIRE(next == std::vector<int>(threadsCount, records));
+    }
+}
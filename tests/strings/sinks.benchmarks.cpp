@@ -0,0 +1,325 @@
+﻿#include <catch/catch.hpp>
+#include <strings/file_sink.h>
+#include <strings/format.h>
+#include <strings/hashing_sink.h>
+#include <strings/ring_sink.h>
+#include <strings/sharded_sink.h>
+#include <strings/sinks.h>
+#include <strings/string_functions.h>
+#include <utility/benchmark.h>
+#include <array_size.h>
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace
+{
+    const size_t iterations = 200;
+    const size_t lines = 20000;
+}
+
+TEST_CASE("fixed buffer sink benchmark", "[.][benchmark][sinks]")
+{
+    const size_t calls = 2000000;
+    char buffer[128];
+    const char *name = "request";
+
+    double staticArray = utility::measure_nanoseconds(calls, [&](size_t i) {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        return strings::format_to(sink, "{}: {} ({:x})", name, i, i);
+    });
+    double truncating = utility::measure_nanoseconds(calls, [&](size_t i) {
+        strings::truncating_sink sink(buffer);
+        return strings::format_to(sink, "{}: {} ({:x})", name, i, i);
+    });
+    double counting = utility::measure_nanoseconds(calls, [&](size_t i) {
+        strings::counting_sink sink;
+        return strings::format_to(sink, "{}: {} ({:x})", name, i, i);
+    });
+
+    std::string line(100, 'x');
+    double staticArrayAppend = utility::measure_nanoseconds(calls, [&](size_t i) {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        sink.append(line.data(), line.size() - i % 2);
+        return sink.size();
+    });
+    double truncatingAppend = utility::measure_nanoseconds(calls, [&](size_t i) {
+        strings::truncating_sink sink(buffer);
+        sink.append(line.data(), line.size() - i % 2);
+        return sink.size();
+    });
+
+    std::wstring wideLine(50, L'\u00e9');
+    double wideCopy = utility::measure_nanoseconds(calls, [&](size_t i) {
+        return strings::string_copy(buffer, ArraySize(buffer), wideLine.data(), wideLine.size() - i % 2);
+    });
+    double wideAppend = utility::measure_nanoseconds(calls, [&](size_t i) {
+        strings::static_array_sink sink(buffer, ArraySize(buffer));
+        sink.append(wideLine.data(), wideLine.size() - i % 2);
+        return sink.size();
+    });
+
+    utility::report_benchmark("static_array_sink format_to", staticArray);
+    utility::report_benchmark("truncating_sink format_to", truncating, staticArray);
+    utility::report_benchmark("counting_sink format_to", counting, staticArray);
+    utility::report_benchmark("static_array_sink append (100 chars)", staticArrayAppend);
+    utility::report_benchmark("truncating_sink append (100 chars)", truncatingAppend, staticArrayAppend);
+    utility::report_benchmark("string_copy (50 wide chars)", wideCopy);
+    utility::report_benchmark("static_array_sink append (50 wide chars)", wideAppend, wideCopy);
+}
+
+namespace
+{
+    /// Compiled formatting routine, which accepts any sink
+    size_t write_fields(strings::any_sink &sink, size_t value)
+    {
+        size_t initialSize = sink.size();
+        for (size_t field = 0; field < 16; ++field)
+        {
+            sink.append(field % 2 == 0 ? "key=" : "value=", field % 2 == 0 ? 4 : 6);
+            sink.append(field % 3 == 0 ? "a;" : "bc;", field % 3 == 0 ? 2 : 3);
+        }
+        strings::formatter arguments[] = { strings::get_formatter(value) };
+        strings::vformat_to(sink, "{}\n", arguments, 1);
+        return sink.size() - initialSize;
+    }
+
+    template <class Sink>
+    size_t write_fields_template(Sink &sink, size_t value)
+    {
+        size_t initialSize = sink.size();
+        for (size_t field = 0; field < 16; ++field)
+        {
+            sink.append(field % 2 == 0 ? "key=" : "value=", field % 2 == 0 ? 4 : 6);
+            sink.append(field % 3 == 0 ? "a;" : "bc;", field % 3 == 0 ? 2 : 3);
+        }
+        strings::format_to(sink, "{}\n", value);
+        return sink.size() - initialSize;
+    }
+}
+
+TEST_CASE("any sink benchmark", "[.][benchmark][sinks]")
+{
+    const size_t calls = 500000;
+    strings::chunked_sink chunks;
+
+    double templateCall = utility::measure_nanoseconds(calls, [&](size_t i) {
+        if (i % 1000 == 0)
+            chunks.clear();
+        return write_fields_template(chunks, i);
+    });
+    double anySinkCall = utility::measure_nanoseconds(calls, [&](size_t i) {
+        if (i % 1000 == 0)
+            chunks.clear();
+        strings::any_sink sink(chunks);
+        return write_fields(sink, i);
+    });
+
+    utility::report_benchmark("template routine over chunked_sink", templateCall);
+    utility::report_benchmark("compiled routine over any_sink", anySinkCall, templateCall);
+}
+
+TEST_CASE("chunked sink benchmark", "[.][benchmark][sinks]")
+{
+    double stringMessage = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        std::string message;
+        for (size_t line = 0; line < lines; ++line)
+            strings::format_to(message, "{}: value {} ({:x})\n", line, i * line, i * line);
+        return message.size();
+    });
+
+    strings::chunked_sink reused;
+    double chunkedMessage = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        strings::chunked_sink message;
+        for (size_t line = 0; line < lines; ++line)
+            strings::format_to(message, "{}: value {} ({:x})\n", line, i * line, i * line);
+        return message.size();
+    });
+    double reusedMessage = utility::measure_nanoseconds(iterations, [&](size_t i) {
+        reused.clear();
+        for (size_t line = 0; line < lines; ++line)
+            strings::format_to(reused, "{}: value {} ({:x})\n", line, i * line, i * line);
+        return reused.size();
+    });
+
+    utility::report_benchmark("std::string (20000 lines)", stringMessage);
+    utility::report_benchmark("chunked_sink (20000 lines)", chunkedMessage, stringMessage);
+    utility::report_benchmark("chunked_sink, reused (20000 lines)", reusedMessage, stringMessage);
+}
+
+TEST_CASE("ring sink benchmark", "[.][benchmark][sinks]")
+{
+    const size_t records = 1000000;
+
+    // worker formats lines, writer thread drains them
+    std::mutex mutex;
+    std::deque<std::string> queue;
+    bool finished = false;
+    size_t queueReceived = 0;
+    std::thread queueWriter([&]() {
+        for (;;) {
+            std::deque<std::string> lines;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                lines.swap(queue);
+                if (lines.empty() && finished)
+                    break;
+            }
+            for (size_t i = 0; i < lines.size(); ++i)
+                queueReceived += lines[i].size();
+            if (lines.empty())
+                std::this_thread::yield();
+        }
+    });
+    double queueProducer = utility::measure_nanoseconds(records, [&](size_t i) {
+        std::string line;
+        strings::format_to(line, "{}: value {} ({:x})\n", "request", i, i);
+        size_t size = line.size();
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(line));
+        return size;
+    });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    queueWriter.join();
+
+    strings::byte_ring ring(1 << 20);
+    std::atomic<bool> done(false);
+    size_t ringReceived = 0;
+    std::thread ringWriter([&]() {
+        strings::string_view spans[2];
+        for (;;) {
+            bool last = done.load();
+            size_t count = ring.peek(spans);
+            size_t size = count == 0 ? 0 : spans[0].size() + spans[1].size();
+            ring.consume(size);
+            ringReceived += size;
+            if (count == 0) {
+                if (last)
+                    break;
+                std::this_thread::yield();
+            }
+        }
+    });
+    double ringProducer = utility::measure_nanoseconds(records, [&](size_t i) {
+        strings::ring_sink sink(ring);
+        return strings::format_to(sink, "{}: value {} ({:x})\n", "request", i, i);
+    });
+    done = true;
+    ringWriter.join();
+
+    utility::report_benchmark("mutex queue of std::string (per line)", queueProducer);
+    utility::report_benchmark("byte_ring + ring_sink (per line)", ringProducer, queueProducer);
+    std::cout << "dropped lines: " << ring.dropped() << ", received bytes: " << queueReceived << " / " << ringReceived << std::endl;
+}
+
+TEST_CASE("sharded sink benchmark", "[.][benchmark][sinks]")
+{
+    const size_t records = 200000;
+    const size_t threadCounts[] = { 1, 4, 16 };
+
+    for (size_t threads : threadCounts) {
+        std::mutex mutex;
+        std::string shared;
+        double locked = utility::measure_parallel_nanoseconds(threads, records / threads, [&](size_t t, size_t i) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (shared.size() > (1 << 20))
+                shared.clear();
+            return strings::format_to(shared, "{}: value {} ({:x})\n", t, i, i);
+        });
+
+        strings::sharded_sink shards;
+        double sharded = utility::measure_parallel_nanoseconds(threads, records / threads, [&](size_t t, size_t i) {
+            strings::sharded_sink::record record(shards);
+            return strings::format_to(record, "{}: value {} ({:x})\n", t, i, i);
+        });
+        strings::counting_sink merged;
+        double merge = utility::measure_nanoseconds(1, [&](size_t) {
+            return shards.merge(merged);
+        });
+
+        std::string suffix = " (" + std::to_string(threads) + " threads)";
+        utility::report_benchmark(("mutex + std::string" + suffix).c_str(), locked);
+        utility::report_benchmark(("sharded_sink" + suffix).c_str(), sharded, locked);
+        utility::report_benchmark(("sharded_sink merge per record" + suffix).c_str(), merge / double(records));
+    }
+}
+
+TEST_CASE("hashing sink benchmark", "[.][benchmark][sinks]")
+{
+    const size_t calls = 500000;
+    std::string text;
+    text.reserve(1024);
+
+    double formatThenHash = utility::measure_nanoseconds(calls, [&](size_t i) {
+        text.clear();
+        strings::format_to(text, "{}: value {} ({:x}) {:.3f}\n", "request", i, i, double(i) / 7);
+        strings::xxhash64 hash;
+        hash.update(text.data(), text.size());
+        strings::crc32c checksum;
+        checksum.update(text.data(), text.size());
+        return hash.digest() + checksum.value();
+    });
+    double hashingSink = utility::measure_nanoseconds(calls, [&](size_t i) {
+        text.clear();
+        strings::hashing_sink<std::string> sink(text);
+        strings::format_to(sink, "{}: value {} ({:x}) {:.3f}\n", "request", i, i, double(i) / 7);
+        return sink.hash() + sink.crc();
+    });
+
+    std::string block(64 * 1024, 'x');
+    double xxhashBlock = utility::measure_nanoseconds(calls / 100, [&](size_t) {
+        strings::xxhash64 hash;
+        hash.update(block.data(), block.size());
+        return hash.digest();
+    });
+    double crcBlock = utility::measure_nanoseconds(calls / 100, [&](size_t) {
+        strings::crc32c checksum;
+        checksum.update(block.data(), block.size());
+        return checksum.value();
+    });
+
+    utility::report_benchmark("format, then xxhash64 + crc32c", formatThenHash);
+    utility::report_benchmark("hashing_sink", hashingSink, formatThenHash);
+    utility::report_benchmark("xxhash64 (64 KB)", xxhashBlock);
+    utility::report_benchmark(strings::crc32c::hardware() ? "crc32c, hardware (64 KB)" : "crc32c, software (64 KB)", crcBlock);
+}
+
+#if defined(PLATFORM_LINUX)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+TEST_CASE("file sink benchmark", "[.][benchmark][sinks]")
+{
+    const size_t messages = 200000;
+    KennyKerr::file_descriptor null(open("/dev/null", O_WRONLY));
+    REQUIRE(null);
+
+    double writePerMessage = utility::measure_nanoseconds(messages, [&](size_t i) {
+        std::string message;
+        strings::format_to(message, "{}: value {} ({:x})\n", "request", i, i);
+        return ::write(null.get(), message.data(), message.size());
+    });
+
+    strings::file_sink buffered(KennyKerr::file_descriptor(open("/dev/null", O_WRONLY)));
+    double bufferedSink = utility::measure_nanoseconds(messages, [&](size_t i) {
+        return strings::format_to(buffered, "{}: value {} ({:x})\n", "request", i, i);
+    });
+
+    strings::file_sink lineBuffered(KennyKerr::file_descriptor(open("/dev/null", O_WRONLY)), strings::file_sink::flush_on_newline);
+    double lineBufferedSink = utility::measure_nanoseconds(messages, [&](size_t i) {
+        return strings::format_to(lineBuffered, "{}: value {} ({:x})\n", "request", i, i);
+    });
+
+    utility::report_benchmark("std::string + write per message", writePerMessage);
+    utility::report_benchmark("file_sink (flush on size)", bufferedSink, writePerMessage);
+    utility::report_benchmark("file_sink (flush on newline)", lineBufferedSink, writePerMessage);
+}
+
+#endif
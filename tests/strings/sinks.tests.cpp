@@ -0,0 +1,271 @@
+﻿#include <catch/catch.hpp>
+#include <strings/format.h>
+#include <strings/sinks.h>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::string chunks_content(const strings::chunked_sink &sink)
+    {
+        std::string content;
+        for (size_t i = 0; i < sink.chunks_count(); ++i)
+            content.append(sink.chunk_data(i), sink.chunk_size(i));
+        return content;
+    }
+
+    /// Non-template function, which writes to any sink
+    void write_values(strings::any_sink &sink, const int *values, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            strings::formatter arguments[] = { strings::get_formatter(int(i)), strings::get_formatter(values[i]) };
+            strings::vformat_to(sink, "{}={};", arguments, 2);
+        }
+    }
+}
+
+TEST_CASE("static array sink tests", "[sinks]") {
+    SECTION("content is copied with terminating zero") {
+        char buffer[16];
+        strings::static_array_sink sink(buffer, sizeof(buffer));
+        sink.append("abc", 3);
+        sink.append("defgh", 2);
+        CHECK(sink.size() == 5);
+        REQUIRE(std::string(buffer) == "abcde");
+    }
+
+    SECTION("content is truncated to buffer size") {
+        char buffer[8];
+        strings::static_array_sink sink(buffer, sizeof(buffer));
+        sink.append("0123456789", 10);
+        CHECK(sink.size() == 7);
+        sink.append("x", 1);
+        CHECK(sink.size() == 7);
+        REQUIRE(std::string(buffer) == "0123456");
+    }
+
+    SECTION("wide characters are converted to UTF-8") {
+        char buffer[32];
+        strings::static_array_sink sink(buffer, sizeof(buffer));
+        sink.append("a", 1);
+        const wchar_t wide[] = L"b\u00e9\u20ac\U0001F600";
+        sink.append(wide, wcslen(wide));
+        CHECK(sink.size() == 11);
+        REQUIRE(std::string(buffer) == "ab\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    }
+
+    SECTION("wide characters are truncated at code point") {
+        char buffer[6];
+        strings::static_array_sink sink(buffer, sizeof(buffer));
+        const wchar_t wide[] = L"ab\u20ac\u20ac";
+        sink.append(wide, wcslen(wide));
+        CHECK(sink.size() == 5);
+        REQUIRE(std::string(buffer) == "ab\xE2\x82\xAC");
+    }
+}
+
+TEST_CASE("truncating sink tests", "[sinks]") {
+    SECTION("content fits") {
+        char buffer[16];
+        strings::truncating_sink sink(buffer);
+        size_t result = strings::format_to(sink, "{}-{}", "abc", 42);
+        CHECK(result == 6);
+        CHECK(sink.size() == 6);
+        CHECK_FALSE(sink.truncated());
+        REQUIRE(std::string(buffer) == "abc-42");
+    }
+
+    SECTION("overflow is recorded instead of throwing") {
+        char buffer[8];
+        strings::truncating_sink sink(buffer, sizeof(buffer));
+        sink.append("0123", 4);
+        CHECK_FALSE(sink.truncated());
+        sink.append("456789", 6);
+        CHECK(sink.truncated());
+        CHECK(sink.size() == 7);
+        sink.append("x", 1);
+        CHECK(sink.size() == 7);
+        REQUIRE(std::string(buffer) == "0123456");
+    }
+
+    SECTION("formatting doesn't throw on overflow") {
+        char buffer[8];
+        strings::truncating_sink sink(buffer);
+        strings::format_to(sink, "{} {}", "long text", 1234567);
+        CHECK(sink.truncated());
+        REQUIRE(std::string(buffer) == "long te");
+    }
+
+    SECTION("wide characters are converted to UTF-8") {
+        char buffer[8];
+        strings::truncating_sink sink(buffer);
+        const wchar_t wide[] = L"\u00e9\u00e9";
+        sink.append(wide, wcslen(wide));
+        CHECK_FALSE(sink.truncated());
+        CHECK(std::string(buffer) == "\xC3\xA9\xC3\xA9");
+        sink.append(wide, wcslen(wide));
+        CHECK(sink.truncated());
+        CHECK(sink.size() == 6);
+        REQUIRE(std::string(buffer) == "\xC3\xA9\xC3\xA9\xC3\xA9");
+    }
+
+    SECTION("empty buffer") {
+        strings::truncating_sink sink(nullptr, 0);
+        sink.append("abc", 3);
+        CHECK(sink.size() == 0);
+        REQUIRE(sink.truncated());
+    }
+}
+
+TEST_CASE("counting sink tests", "[sinks]") {
+    strings::counting_sink sink;
+    sink.append(nullptr, 5);
+    CHECK(sink.size() == 5);
+    strings::format_to(sink, "{}: {:x}", "value", 255);
+    REQUIRE(sink.size() == 5 + strings::formatted_size("{}: {:x}", "value", 255));
+}
+
+TEST_CASE("any sink tests", "[sinks]") {
+    SECTION("small appends are buffered") {
+        std::string text = "> ";
+        {
+            strings::any_sink sink(text);
+            sink.append("abc", 3);
+            sink.append("de", 2);
+            CHECK(text == "> ");
+            CHECK(sink.size() == 7);
+            sink.flush();
+            CHECK(text == "> abcde");
+            sink.append("f", 1);
+        }
+        REQUIRE(text == "> abcdef");
+    }
+
+    SECTION("large content is forwarded directly") {
+        std::string text;
+        strings::any_sink sink(text);
+        sink.append("ab", 2);
+        std::string large(strings::any_sink_buffer_size + 10, 'x');
+        sink.append(large.data(), large.size());
+        CHECK(text == "ab" + large);
+        std::string medium(strings::any_sink_buffer_size - 10, 'y');
+        sink.append("cd", 2);
+        sink.append(medium.data(), medium.size());
+        sink.append(medium.data(), medium.size());
+        CHECK(sink.size() == 2 + large.size() + 2 + 2 * medium.size());
+        sink.flush();
+        REQUIRE(text == "ab" + large + "cd" + medium + medium);
+    }
+
+    SECTION("format through non-template function") {
+        const int values[] = { 10, 20, 30 };
+        std::string text;
+        {
+            strings::any_sink sink(text);
+            write_values(sink, values, 3);
+        }
+        CHECK(text == "0=10;1=20;2=30;");
+
+        strings::chunked_sink chunks(4);
+        {
+            strings::any_sink sink(chunks);
+            write_values(sink, values, 3);
+        }
+        REQUIRE(chunks_content(chunks) == "0=10;1=20;2=30;");
+    }
+
+    SECTION("variadic format to any sink") {
+        std::string text;
+        strings::any_sink sink(text);
+        size_t result = strings::format_to(sink, "{}: {:x}", "value", 255);
+        CHECK(result == 9);
+        sink.flush();
+        REQUIRE(text == "value: ff");
+    }
+}
+
+TEST_CASE("chunked sink tests", "[sinks]") {
+    SECTION("content is split to chunks") {
+        strings::chunked_sink sink(4);
+        sink.append("0123456789", 10);
+        CHECK(sink.size() == 10);
+        CHECK(sink.chunks_count() == 3);
+        CHECK(sink.chunk_size(0) == 4);
+        CHECK(sink.chunk_size(2) == 2);
+        REQUIRE(chunks_content(sink) == "0123456789");
+    }
+
+    SECTION("written data isn't moved") {
+        strings::chunked_sink sink(8);
+        sink.append("abcdef", 6);
+        const char *first = sink.chunk_data(0);
+        for (int i = 0; i < 100; ++i)
+            sink.append("xyz", 3);
+        CHECK(sink.chunk_data(0) == first);
+        REQUIRE(sink.size() == 306);
+    }
+
+    SECTION("reserve allocates missing space once") {
+        strings::chunked_sink sink(4);
+        sink.append("ab", 2);
+        sink.reserve(100);
+        std::string text(98, 'x');
+        sink.append(text.data(), text.size());
+        CHECK(sink.chunks_count() == 2);
+        CHECK(sink.chunk_size(0) == 4);
+        CHECK(sink.chunk_size(1) == 96);
+        REQUIRE(chunks_content(sink) == "ab" + text);
+    }
+
+    SECTION("format into chunked sink") {
+        strings::chunked_sink sink(16);
+        for (int i = 0; i < 10; ++i)
+            strings::format_to(sink, "{}: {:x};", i, i * 100);
+        std::string expected;
+        for (int i = 0; i < 10; ++i)
+            strings::format_to(expected, "{}: {:x};", i, i * 100);
+        CHECK(sink.size() == expected.size());
+        REQUIRE(chunks_content(sink) == expected);
+    }
+
+    SECTION("clear keeps chunks for reuse") {
+        strings::chunked_sink sink(4);
+        sink.append("0123456789", 10);
+        const char *first = sink.chunk_data(0);
+        sink.clear();
+        CHECK(sink.size() == 0);
+        CHECK(sink.chunks_count() == 0);
+        sink.append("abcde", 5);
+        CHECK(sink.chunk_data(0) == first);
+        REQUIRE(chunks_content(sink) == "abcde");
+    }
+
+    SECTION("copy to buffer") {
+        strings::chunked_sink sink(3);
+        sink.append("0123456789", 10);
+        char buffer[8];
+        CHECK(sink.copy_to(buffer, sizeof(buffer)) == 8);
+        REQUIRE(std::string(buffer, 8) == "01234567");
+    }
+
+#if !defined(_WIN32)
+    SECTION("export to iovec") {
+        strings::chunked_sink sink(4);
+        sink.append("0123456789", 10);
+        std::vector<iovec> vectors(8);
+        size_t count = sink.to_iovec(vectors.data(), vectors.size());
+        CHECK(count == 3);
+        std::string content;
+        for (size_t i = 0; i < count; ++i)
+            content.append(static_cast<const char *>(vectors[i].iov_base), vectors[i].iov_len);
+        CHECK(content == "0123456789");
+
+        CHECK(sink.to_iovec(vectors.data(), 2) == 2);
+        CHECK(sink.to_iovec(vectors.data(), 8, 2) == 1);
+        CHECK(vectors[0].iov_len == 2);
+        REQUIRE(sink.to_iovec(vectors.data(), 8, 5) == 0);
+    }
+#endif
+}
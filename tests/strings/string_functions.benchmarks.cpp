@@ -0,0 +1,66 @@
+﻿#include <catch/catch.hpp>
+#include <strings/string_functions.h>
+#include <utility/benchmark.h>
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /// Previous implementation: clear, strncat, strlen
+    size_t three_pass_copy(char *buffer, size_t bufferMaxSize, const char *source, size_t sourceSize)
+    {
+        strcpy(buffer, "");
+        strncat(buffer, source, std::min(bufferMaxSize - 1, sourceSize));
+        return strlen(buffer);
+    }
+
+    size_t three_pass_copy(wchar_t *buffer, size_t bufferMaxSize, const wchar_t *source)
+    {
+        wcscpy(buffer, L"");
+        wcsncat(buffer, source, bufferMaxSize - 1);
+        return wcslen(buffer);
+    }
+}
+
+TEST_CASE("string_copy benchmark", "[.][benchmark][string_functions]")
+{
+    const size_t sizes[] = { 8, 64, 512, 4096, 65536 };
+    std::vector<char> buffer(65536 + 1);
+    std::vector<wchar_t> wideBuffer(65536 + 1);
+
+    for (size_t size : sizes) {
+        std::string source(size, 'x');
+        std::wstring wideSource(size, L'x');
+        size_t iterations = std::max<size_t>(1000, 64 * 1024 * 1024 / (size * 16));
+
+        double oldSized = utility::measure_nanoseconds(iterations, [&](size_t) {
+            return three_pass_copy(buffer.data(), buffer.size(), source.data(), source.size());
+        });
+        double newSized = utility::measure_nanoseconds(iterations, [&](size_t) {
+            return strings::string_copy(buffer.data(), buffer.size(), source.data(), source.size());
+        });
+        double oldTerminated = utility::measure_nanoseconds(iterations, [&](size_t) {
+            return three_pass_copy(buffer.data(), buffer.size(), source.c_str(), buffer.size());
+        });
+        double newTerminated = utility::measure_nanoseconds(iterations, [&](size_t) {
+            return strings::string_copy(buffer.data(), buffer.size(), source.c_str());
+        });
+        double oldWide = utility::measure_nanoseconds(iterations, [&](size_t) {
+            return three_pass_copy(wideBuffer.data(), wideBuffer.size(), wideSource.c_str());
+        });
+        double newWide = utility::measure_nanoseconds(iterations, [&](size_t) {
+            return strings::string_copy(wideBuffer.data(), wideBuffer.size(), wideSource.c_str());
+        });
+
+        std::string suffix = " (" + std::to_string(size) + " chars)";
+        utility::report_benchmark(("strncat + strlen, sized" + suffix).c_str(), oldSized);
+        utility::report_benchmark(("string_copy, sized" + suffix).c_str(), newSized, oldSized);
+        utility::report_benchmark(("strncat + strlen, terminated" + suffix).c_str(), oldTerminated);
+        utility::report_benchmark(("string_copy, terminated" + suffix).c_str(), newTerminated, oldTerminated);
+        utility::report_benchmark(("wcsncat + wcslen, terminated" + suffix).c_str(), oldWide);
+        utility::report_benchmark(("string_copy, wide terminated" + suffix).c_str(), newWide, oldWide);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef __BENCHMARK_HEADER_H__
+#define __BENCHMARK_HEADER_H__
+
+#include <platform/performance_counter.h>
+#include <atomic>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace utility
+{
+    /// \brief Measure average duration of single call in nanoseconds.
+    ///
+    /// Function is called with iteration index and should return some value
+    /// depending on computation result (e.g. count of formatted characters),
+    /// so compiler can't throw computation away.
+    ///
+    /// ~~~{.c}
+    /// double ns = utility::measure_nanoseconds(1000000, [&](size_t i) {
+    ///     return strings::str_printf(buffer, ArraySize(buffer), "%d", int(i));
+    /// });
+    /// ~~~
+    template <class Function>
+    double measure_nanoseconds(size_t iterations, Function function)
+    {
+        volatile size_t result = 0;
+        platform::performance_counter timer;
+        {
+            platform::performance_scope scope(timer);
+            for (size_t i = 0; i < iterations; ++i)
+                result = result + size_t(function(i));
+        }
+        return timer.get_seconds() * 1e9 / double(iterations);
+    }
+
+    /// \brief Run function on several threads simultaneously and measure wall-clock
+    ///        duration per call of all threads in nanoseconds.
+    ///
+    /// Function is called with thread index and iteration index. With perfect scaling
+    /// result is divided by count of threads (until there are enough processors).
+    template <class Function>
+    double measure_parallel_nanoseconds(size_t threadsCount, size_t iterations, Function function)
+    {
+        std::atomic<size_t> ready(0);
+        std::atomic<bool> start(false);
+        std::atomic<size_t> result(0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadsCount; ++t)
+        {
+            threads.push_back(std::thread([&, t]() {
+                ++ready;
+                while (!start.load())
+                    std::this_thread::yield();
+                size_t local = 0;
+                for (size_t i = 0; i < iterations; ++i)
+                    local += size_t(function(t, i));
+                result += local;
+            }));
+        }
+        while (ready.load() != threadsCount)
+            std::this_thread::yield();
+
+        platform::performance_counter timer;
+        {
+            platform::performance_scope scope(timer);
+            start = true;
+            for (size_t t = 0; t < threadsCount; ++t)
+                threads[t].join();
+        }
+        return timer.get_seconds() * 1e9 / double(iterations * threadsCount);
+    }
+
+    /// \brief Print benchmark result line: name, ns per call and speedup relative to baseline.
+    inline void report_benchmark(const char *name, double nanoseconds, double baselineNanoseconds = 0)
+    {
+        std::ios::fmtflags flags = std::cout.flags();
+        std::cout << std::left << std::setw(48) << name
+                  << std::right << std::setw(10) << std::fixed << std::setprecision(2) << nanoseconds << " ns/call";
+        if (baselineNanoseconds > 0 && nanoseconds > 0)
+            std::cout << "  x" << std::setprecision(2) << baselineNanoseconds / nanoseconds;
+        std::cout << std::endl;
+        std::cout.flags(flags);
+    }
+}
+
+#endif